@@ -0,0 +1,126 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include "glm/glm/glm.hpp"
+#include "../bvh.hpp"
+#include "../raycast.hpp"
+
+// Builds the BVH over cities of 10k to 1M buildings shaped like init_world's, then times its queries,
+// checking a sample of the rays against every box
+
+std::vector<Bounds> random_city(size_t count, float half, std::mt19937& gen) {
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<Bounds> city;
+    city.push_back({glm::vec3(-half, -0.05f, -half), glm::vec3(half, 0.05f, half)});
+    for (size_t i = 0; i < count; i += 1) {
+        glm::vec3 size(30.0f + unit(gen) * 50.0f, 10.0f + unit(gen) * 90.0f, 30.0f + unit(gen) * 50.0f);
+        glm::vec3 center(unit(gen) * 2.0f * half - half, size.y / 2, unit(gen) * 2.0f * half - half);
+        city.push_back({center - size / 2.0f, center + size / 2.0f});
+    }
+    return city;
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    const float reach = 100.0f;
+    const size_t queries = 200000;
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+
+    size_t counts[] = {10000, 100000, 1000000};
+    for (size_t count : counts) {
+        float half = std::sqrt((float)count) * 15.0f;
+        std::vector<Bounds> city = random_city(count, half, gen);
+
+        auto start = std::chrono::steady_clock::now();
+        Bvh bvh;
+        bvh.build(city);
+        double build = seconds_since(start);
+        std::cout << count << " buildings: build " << build * 1000.0 << " ms (" << bvh.getNodeCount() << " nodes, depth " << bvh.getDepth()
+                  << ")" << std::endl;
+
+        // Street-level rays in random directions
+        std::vector<glm::vec3> origins, directions;
+        for (size_t i = 0; i < queries; i += 1) {
+            origins.push_back(glm::vec3(unit(gen) * 2.0f * half - half, 2.0f, unit(gen) * 2.0f * half - half));
+            directions.push_back(glm::normalize(glm::vec3(normal(gen), normal(gen), normal(gen))));
+        }
+        size_t hits = 0;
+        size_t mismatches = 0;
+        std::vector<float> distances(queries, -1.0f);
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries; i += 1) {
+            RayHit hit;
+            uint32_t object;
+            if (bvh.raycast(origins[i], directions[i], reach, hit, object)) {
+                distances[i] = hit.distance;
+                hits += 1;
+            }
+        }
+        double rays = seconds_since(start);
+        for (size_t i = 0; i < queries; i += queries / 100) {
+            glm::vec3 inverse_direction = 1.0f / directions[i];
+            float distance = -1.0f;
+            for (const Bounds& bounds : city) {
+                float enter, leave;
+                int axis;
+                if (clip_ray(bounds, origins[i], inverse_direction, reach, enter, leave, axis) && axis >= 0 && (distance < 0.0f || enter < distance)) {
+                    distance = enter;
+                }
+            }
+            mismatches += std::fabs(distance - distances[i]) > 1e-3f ? 1 : 0;
+        }
+        std::cout << "  rays: " << rays * 1e9 / queries << " ns, " << 100.0 * hits / queries << "% hit"
+                  << (mismatches > 0 ? ", MISMATCH" : "") << std::endl;
+
+        // A player-sized box and a 20-unit neighbourhood around the same points
+        std::vector<uint32_t> found;
+        glm::vec3 extents[] = {glm::vec3(0.5f, 1.0f, 0.5f), glm::vec3(10.0f)};
+        for (const glm::vec3& extent : extents) {
+            size_t total = 0;
+            start = std::chrono::steady_clock::now();
+            for (size_t i = 0; i < queries; i += 1) {
+                found.clear();
+                bvh.overlap(Bounds{origins[i] - extent, origins[i] + extent}, found);
+                total += found.size();
+            }
+            std::cout << "  overlap " << extent.x * 2.0f << "x" << extent.y * 2.0f << "x" << extent.z * 2.0f << ": "
+                      << seconds_since(start) * 1e9 / queries << " ns, " << (double)total / queries << " boxes" << std::endl;
+        }
+
+        // Nearest building from above the roofs, so the ground never wins
+        float total_distance = 0.0f;
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < queries; i += 1) {
+            uint32_t object;
+            float distance;
+            if (bvh.nearest(origins[i] + glm::vec3(0.0f, 150.0f, 0.0f), 1e9f, object, distance)) {
+                total_distance += distance;
+            }
+        }
+        std::cout << "  nearest: " << seconds_since(start) * 1e9 / queries << " ns, " << total_distance / queries << " units away" << std::endl;
+
+        // Boxes added after the build go in through insert(); moving boxes goes through update() and refit()
+        std::vector<Bounds> extra = random_city(1000, half, gen);
+        start = std::chrono::steady_clock::now();
+        for (const Bounds& bounds : extra) {
+            bvh.insert(bounds);
+        }
+        double insert = seconds_since(start);
+        for (size_t i = 1; i < bvh.getObjectCount(); i += 10) {
+            Bounds bounds = bvh.getBounds(i);
+            bounds.max.y += 1.0f;
+            bvh.update(i, bounds);
+        }
+        start = std::chrono::steady_clock::now();
+        bvh.refit();
+        std::cout << "  insert: " << insert * 1e9 / extra.size() << " ns per box, refit " << seconds_since(start) * 1000.0 << " ms" << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,71 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cstring>
+#include "glm/glm/glm.hpp"
+#include "glm/glm/gtc/matrix_transform.hpp"
+#include "../frustum.hpp"
+
+// Compares the scalar and SIMD frustum kernels on random city-sized boxes seen from the default camera
+
+BoundsArray random_bounds(size_t count) {
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<float> position(-500.0f, 500.0f);
+    std::uniform_real_distribution<float> extent(1.0f, 80.0f);
+
+    BoundsArray bounds;
+    for (size_t i = 0; i < count; i += 1) {
+        Bounds box;
+        box.min = glm::vec3(position(gen), 0.0f, position(gen));
+        box.max = box.min + glm::vec3(extent(gen), extent(gen), extent(gen));
+        bounds.push_back(box);
+    }
+
+    return bounds;
+}
+
+template <typename Kernel>
+double time_kernel(size_t count, int repeats, Kernel kernel) {
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r += 1) {
+        kernel();
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return seconds * 1e9 / ((double)count * repeats);
+}
+
+int main(int argc, char* argv[]) {
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1200.0f / 800.0f, 0.1f, 1000.0f);
+    glm::mat4 view = glm::lookAt(glm::vec3(0.0f, 2.0f, 0.0f), glm::vec3(0.0f, 2.0f, -1.0f), glm::vec3(0.0f, 1.0f, 0.0f));
+    Frustum frustum = Frustum(projection * view);
+
+    size_t sizes[] = {10000, 100000, 1000000};
+    for (size_t count : sizes) {
+        BoundsArray bounds = random_bounds(count);
+        std::vector<unsigned char> expected(count);
+        std::vector<unsigned char> visible(count);
+        int repeats = (int)(20000000 / count);
+
+        double scalar = time_kernel(count, repeats, [&]() { frustum.test_scalar(bounds, 0, expected.data()); });
+        size_t inside = 0;
+        for (unsigned char v : expected) {
+            inside += v;
+        }
+        std::cout << count << " boxes (" << inside << " visible): scalar " << scalar << " ns/box";
+
+#ifdef __SSE2__
+        double sse = time_kernel(count, repeats, [&]() { frustum.test_sse(bounds, visible.data()); });
+        bool sse_match = memcmp(expected.data(), visible.data(), count) == 0;
+        std::cout << ", sse " << sse << " ns/box (" << scalar / sse << "x" << (sse_match ? "" : ", MISMATCH") << ")";
+#endif
+#ifdef __AVX__
+        double avx = time_kernel(count, repeats, [&]() { frustum.test_avx(bounds, visible.data()); });
+        bool avx_match = memcmp(expected.data(), visible.data(), count) == 0;
+        std::cout << ", avx " << avx << " ns/box (" << scalar / avx << "x" << (avx_match ? "" : ", MISMATCH") << ")";
+#endif
+        std::cout << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,173 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <algorithm>
+#include <limits>
+#include "glm/glm/glm.hpp"
+#include "glm/glm/gtc/matrix_transform.hpp"
+#include "../frustum.hpp"
+#include "../occlusion.hpp"
+#include "../thread_pool.hpp"
+#include "../raycast.hpp"
+#include "../bvh.hpp"
+
+// Renders the nearest 64 large buildings of a 20k-building city into the occlusion buffer from points along a
+// street-level loop, on one thread and on all of them, then times testing every box left after frustum culling.
+// Every rejected box is checked against a ray-cast reference, and any that can be seen makes the run fail, as does
+// a wall with an almost level edge that fails to hide the box behind it.
+
+std::vector<Bounds> random_city(size_t count, float half) {
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    std::vector<Bounds> city;
+    for (size_t i = 0; i < count; i += 1) {
+        glm::vec3 size(30.0f + unit(gen) * 50.0f, 10.0f + unit(gen) * 90.0f, 30.0f + unit(gen) * 50.0f);
+        glm::vec3 center(unit(gen) * 2.0f * half - half, size.y / 2, unit(gen) * 2.0f * half - half);
+        city.push_back({center - size / 2.0f, center + size / 2.0f});
+    }
+    return city;
+}
+
+float distance_to(const Bounds& bounds, const glm::vec3& point) {
+    return glm::length(glm::max(glm::max(bounds.min - point, point - bounds.max), glm::vec3(0.0f)));
+}
+
+// Whether add_occluder draws the box: every corner in front of the near plane and far enough from the eye's plane
+bool drawn(const Bounds& bounds, const glm::mat4& view_projection) {
+    for (int i = 0; i < 8; i += 1) {
+        glm::vec4 clip = view_projection * glm::vec4(i & 1 ? bounds.max.x : bounds.min.x, i & 2 ? bounds.max.y : bounds.min.y, i & 4 ? bounds.max.z : bounds.min.z, 1.0f);
+        if (clip.w < OCCLUSION_MIN_W || clip.z < -clip.w) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Rejected boxes that can be seen: a ray from the eye through the center of some pixel of the buffer meets one before
+// it meets any occluder. Pixel centers are what the buffer promises to get right.
+size_t seen_rejected(const std::vector<Bounds>& rejected, const std::vector<Bounds>& occluders, const glm::mat4& view_projection, const glm::vec3& eye) {
+    if (rejected.empty()) {
+        return 0;
+    }
+    Bvh tree;
+    tree.build(rejected);
+    std::vector<bool> seen(rejected.size(), false);
+    glm::mat4 unproject = glm::inverse(view_projection);
+    for (int y = 0; y < OCCLUSION_HEIGHT; y += 1) {
+        for (int x = 0; x < OCCLUSION_WIDTH; x += 1) {
+            glm::vec4 far = unproject * glm::vec4((x + 0.5f) / OCCLUSION_WIDTH * 2.0f - 1.0f, (y + 0.5f) / OCCLUSION_HEIGHT * 2.0f - 1.0f, 1.0f, 1.0f);
+            glm::vec3 direction = glm::normalize(glm::vec3(far) / far.w - eye);
+            glm::vec3 inverse_direction = 1.0f / direction;
+            float nearest = std::numeric_limits<float>::infinity();
+            for (const Bounds& bounds : occluders) {
+                float enter, leave;
+                int axis;
+                if (clip_ray(bounds, eye, inverse_direction, nearest, enter, leave, axis) && axis >= 0) {
+                    nearest = enter;
+                }
+            }
+            RayHit hit;
+            uint32_t box;
+            if (tree.raycast(eye, direction, nearest, hit, box)) {
+                seen[box] = true;
+            }
+        }
+    }
+    return std::count(seen.begin(), seen.end(), true);
+}
+
+double seconds_since(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+int main(int argc, char* argv[]) {
+    const float half = 1500.0f;
+    const int views = 16;
+    const int repeats = 20;
+    std::vector<Bounds> city = random_city(20000, half);
+    glm::mat4 projection = glm::perspective(glm::radians(45.0f), 1200.0f / 800.0f, 0.1f, 1000.0f);
+
+    ThreadPool single(1);
+    ThreadPool all(0);
+    OcclusionBuffer buffer;
+    double render_single = 0.0, render_all = 0.0, test = 0.0;
+    size_t tested = 0, rejected = 0, triangles = 0, wrong = 0;
+    for (int view = 0; view < views; view += 1) {
+        float angle = 2.0f * glm::pi<float>() * view / views;
+        glm::vec3 eye = glm::vec3(half / 2 * std::cos(angle), 2.0f, half / 2 * std::sin(angle));
+        glm::vec3 forward = glm::vec3(-std::sin(angle), 0.0f, std::cos(angle));
+        glm::mat4 view_projection = projection * glm::lookAt(eye, eye + forward, glm::vec3(0.0f, 1.0f, 0.0f));
+        Frustum frustum = Frustum(view_projection);
+
+        std::vector<Bounds> in_view, occluders;
+        for (const Bounds& bounds : city) {
+            if (frustum.intersects(bounds)) {
+                in_view.push_back(bounds);
+            }
+        }
+        occluders = in_view;
+        std::sort(occluders.begin(), occluders.end(), [&](const Bounds& a, const Bounds& b) {
+            return distance_to(a, eye) < distance_to(b, eye);
+        });
+        occluders.resize(std::min<size_t>(occluders.size(), 64));
+
+        auto start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; r += 1) {
+            buffer.render(view_projection, eye, occluders, single);
+        }
+        render_single += seconds_since(start);
+        start = std::chrono::steady_clock::now();
+        for (int r = 0; r < repeats; r += 1) {
+            buffer.render(view_projection, eye, occluders, all);
+        }
+        render_all += seconds_since(start);
+        triangles += buffer.getTriangleCount();
+
+        start = std::chrono::steady_clock::now();
+        for (const Bounds& bounds : in_view) {
+            rejected += buffer.visible(bounds) ? 0 : 1;
+        }
+        test += seconds_since(start);
+        tested += in_view.size();
+
+        std::vector<Bounds> hidden, drawn_occluders;
+        for (const Bounds& bounds : in_view) {
+            if (!buffer.visible(bounds)) {
+                hidden.push_back(bounds);
+            }
+        }
+        for (const Bounds& bounds : occluders) {
+            if (drawn(bounds, view_projection)) {
+                drawn_occluders.push_back(bounds);
+            }
+        }
+        wrong += seen_rejected(hidden, drawn_occluders, view_projection, eye);
+    }
+
+    // A wall across the view with the camera rolled by a hair, so the wall's bottom edge is almost level on screen
+    // and crosses every row far outside the buffer. The wall must still be drawn and hide the box behind it.
+    glm::vec3 eye = glm::vec3(0.0f, 2.0f, 0.0f);
+    glm::mat4 view_projection = projection * glm::lookAt(eye, glm::vec3(0.0f, 2.0f, 1.0f), glm::vec3(std::sin(1e-9f), std::cos(1e-9f), 0.0f));
+    std::vector<Bounds> wall = {{glm::vec3(-100.0f, 0.0f, 5.5f), glm::vec3(100.0f, 50.0f, 6.5f)}};
+    std::vector<Bounds> behind = {{glm::vec3(-2.0f, 0.0f, 20.0f), glm::vec3(2.0f, 10.0f, 24.0f)}};
+    buffer.render(view_projection, eye, wall, single);
+    bool wall_hides = !buffer.visible(behind[0]);
+    if (wall_hides) {
+        wrong += seen_rejected(behind, wall, view_projection, eye);
+    }
+
+    std::cout << "render " << (double)triangles / views << " triangles: " << render_single * 1000.0 / (views * repeats) << " ms on 1 thread, "
+              << render_all * 1000.0 / (views * repeats) << " ms on " << all.getThreadCount() << " threads" << std::endl;
+    std::cout << "test: " << test * 1e9 / tested << " ns per box, " << 100.0 * rejected / tested << "% of " << tested / views
+              << " boxes in view rejected" << std::endl;
+    if (!wall_hides) {
+        std::cout << "FAILED: a wall with an almost level edge hides nothing" << std::endl;
+        return 1;
+    }
+    if (wrong > 0) {
+        std::cout << "FAILED: " << wrong << " rejected boxes can be seen in front of the occluders" << std::endl;
+        return 1;
+    }
+    return 0;
+}
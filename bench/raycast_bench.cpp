@@ -0,0 +1,118 @@
+#include <iostream>
+#include <vector>
+#include <random>
+#include <chrono>
+#include <cmath>
+#include "glm/glm/glm.hpp"
+#include "../voxels.hpp"
+#include "../raycast.hpp"
+#include "../bvh.hpp"
+
+// Times crosshair-length rays (100 units) against a million placed blocks and against a city of buildings
+
+std::vector<glm::vec3> random_directions(size_t count, std::mt19937& gen) {
+    std::normal_distribution<float> normal(0.0f, 1.0f);
+    std::vector<glm::vec3> directions;
+    while (directions.size() < count) {
+        glm::vec3 direction(normal(gen), normal(gen), normal(gen));
+        if (glm::length(direction) > 1e-3f) {
+            directions.push_back(glm::normalize(direction));
+        }
+    }
+    return directions;
+}
+
+template <typename Cast>
+void time_rays(const char* name, const std::vector<glm::vec3>& origins, const std::vector<glm::vec3>& directions, Cast cast) {
+    size_t hits = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (size_t i = 0; i < origins.size(); i += 1) {
+        RayHit hit;
+        hits += cast(origins[i], directions[i], hit) ? 1 : 0;
+    }
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::cout << "  " << name << ": " << seconds * 1e9 / origins.size() << " ns/ray, " << 100.0 * hits / origins.size() << "% hit" << std::endl;
+}
+
+// Random rays spread over the whole store miss the cache on nearly every brick. A crosshair ray moves a little each
+// frame instead: this path circles the store at height y, looking ahead and slowly up and down.
+void camera_sweep(size_t count, float radius, float y, std::vector<glm::vec3>& origins, std::vector<glm::vec3>& directions) {
+    origins.clear();
+    directions.clear();
+    for (size_t i = 0; i < count; i += 1) {
+        float angle = 2.0f * 3.14159265f * i / count;
+        float pitch = 0.5f * std::sin(angle * 200.0f);
+        origins.push_back(glm::vec3(radius * std::cos(angle), y, radius * std::sin(angle)));
+        directions.push_back(glm::normalize(glm::vec3(-std::sin(angle), pitch, std::cos(angle))));
+    }
+}
+
+int main(int argc, char* argv[]) {
+    const float reach = 100.0f;
+    const size_t rays = 1000000;
+    std::mt19937 gen(1);
+    std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+    Color color = {0.5f, 0.5f, 0.5f};
+    std::vector<glm::vec3> origins;
+    std::vector<glm::vec3> directions = random_directions(rays, gen);
+
+    // A 1000 x 1000 floor of blocks, seen from just above it
+    VoxelStore floor;
+    for (int x = -500; x < 500; x += 1) {
+        for (int z = -500; z < 500; z += 1) {
+            floor.add(x, 0, z, color);
+        }
+    }
+    auto cast_floor = [&](const glm::vec3& o, const glm::vec3& d, RayHit& hit) { return floor.raycast(o, d, reach, hit); };
+    std::cout << floor.getCount() << " blocks as a floor in " << floor.getBrickCount() << " bricks" << std::endl;
+    for (size_t i = 0; i < rays; i += 1) {
+        origins.push_back(glm::vec3(unit(gen) * 800.0f - 400.0f, 2.0f + unit(gen) * 20.0f, unit(gen) * 800.0f - 400.0f));
+    }
+    time_rays("random", origins, directions, cast_floor);
+    std::vector<glm::vec3> sweep_origins, sweep_directions;
+    camera_sweep(rays, 250.0f, 2.0f, sweep_origins, sweep_directions);
+    time_rays("camera sweep", sweep_origins, sweep_directions, cast_floor);
+
+    // The same number of blocks scattered through 1000 x 64 x 1000, so rays cross many allocated bricks
+    VoxelStore scattered;
+    std::uniform_int_distribution<int> xz(-500, 499);
+    std::uniform_int_distribution<int> y(0, 63);
+    while (scattered.getCount() < 1000000) {
+        scattered.add(xz(gen), y(gen), xz(gen), color);
+    }
+    auto cast_scattered = [&](const glm::vec3& o, const glm::vec3& d, RayHit& hit) { return scattered.raycast(o, d, reach, hit); };
+    std::cout << scattered.getCount() << " blocks scattered in " << scattered.getBrickCount() << " bricks" << std::endl;
+    for (glm::vec3& origin : origins) {
+        origin.y = unit(gen) * 64.0f;
+    }
+    time_rays("random", origins, directions, cast_scattered);
+    camera_sweep(rays, 250.0f, 32.0f, sweep_origins, sweep_directions);
+    time_rays("camera sweep", sweep_origins, sweep_directions, cast_scattered);
+
+    // Buildings as init_world makes them, on a ground box
+    size_t counts[] = {3000, 100000};
+    for (size_t count : counts) {
+        float half = std::sqrt((float)count) * 15.0f;
+        std::vector<Bounds> city;
+        city.push_back({glm::vec3(-half, -0.05f, -half), glm::vec3(half, 0.05f, half)});
+        for (size_t i = 0; i < count; i += 1) {
+            glm::vec3 size(30.0f + unit(gen) * 50.0f, 10.0f + unit(gen) * 90.0f, 30.0f + unit(gen) * 50.0f);
+            glm::vec3 center(unit(gen) * 2.0f * half - half, size.y / 2, unit(gen) * 2.0f * half - half);
+            city.push_back({center - size / 2.0f, center + size / 2.0f});
+        }
+        Bvh tree;
+        tree.build(city);
+        for (glm::vec3& origin : origins) {
+            origin = glm::vec3(unit(gen) * 2.0f * half - half, 2.0f, unit(gen) * 2.0f * half - half);
+        }
+        auto cast_buildings = [&](const glm::vec3& o, const glm::vec3& d, RayHit& hit) {
+            uint32_t box;
+            return tree.raycast(o, d, reach, hit, box);
+        };
+        std::cout << count << " buildings in " << tree.getNodeCount() << " nodes" << std::endl;
+        time_rays("random", origins, directions, cast_buildings);
+        camera_sweep(rays, half / 2.0f, 2.0f, sweep_origins, sweep_directions);
+        time_rays("camera sweep", sweep_origins, sweep_directions, cast_buildings);
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include "glm/glm/glm.hpp"
+#include "glm/glm/gtc/matrix_transform.hpp"
+#include "../headless.hpp"
+#include "../shader.hpp"
+#include "../mesh.hpp"
+#include "../cube.hpp"
+
+// Vertex throughput of the basic.vs variants, rendered offscreen. The cubes are far smaller than a pixel,
+// so on a software rasterizer the frame time is almost all vertex shading. Run from the repository root.
+
+const int FRAMEBUFFER_SIZE = 256;
+const int CUBES = 50000;
+const int FRAMES = 20;
+
+std::vector<Vertex> tiny_cubes() {
+    std::vector<Vertex> vertices(CUBES * CUBE_VERTICES);
+    CubeSize size = {0.01f, 0.01f, 0.01f};
+    Color color = {1.0f, 1.0f, 1.0f};
+    for (int i = 0; i < CUBES; i += 1) {
+        Origin origin = {(i % 250) * 0.4f - 50.0f, (i / 250) * 0.25f - 25.0f, -100.0f};
+        write_cube(size, origin, color, &vertices[i * CUBE_VERTICES]);
+    }
+    return vertices;
+}
+
+// Milliseconds per frame over FRAMES frames, after one warm-up frame that also compiles the draw state
+double time_variant(Shader& shader, Mesh& mesh, size_t vertex_count) {
+    glUseProgram(shader.getProgram());
+    glm::mat4 model = glm::mat4(1.0f);
+    shader.set_uniform(shader.getUniform("model"), model);
+    shader.set_uniform(shader.getUniform("normalMatrix"), glm::transpose(glm::inverse(glm::mat3(model))));
+    glBindVertexArray(mesh.getVAO());
+
+    double total = 0.0;
+    for (int frame = -1; frame < FRAMES; frame += 1) {
+        auto start = std::chrono::steady_clock::now();
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        glDrawArrays(GL_TRIANGLES, 0, vertex_count);
+        glFinish();
+        if (frame >= 0) {
+            total += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        }
+    }
+    return total / FRAMES;
+}
+
+int main(int argc, char* argv[]) {
+    HeadlessContext context;
+    if (!context.create(FRAMEBUFFER_SIZE, FRAMEBUFFER_SIZE)) {
+        return -1;
+    }
+    std::cout << "Renderer: " << glGetString(GL_RENDERER) << " through " << context.getBackend() << std::endl;
+    glEnable(GL_DEPTH_TEST);
+
+    std::vector<Vertex> vertices = tiny_cubes();
+    Mesh mesh;
+    mesh.bind_buffers(vertices);
+
+    FrameUniforms frame;
+    frame.view = glm::mat4(1.0f);
+    frame.projection = glm::perspective(glm::radians(45.0f), 1.0f, 0.1f, 1000.0f);
+    frame.view_projection = frame.projection * frame.view;
+    frame.camera_position = glm::vec4(0.0f, 0.0f, 0.0f, 1.0f);
+    frame.light_position = glm::vec4(10.0f, 100.0f, 10.0f, 1.0f);
+    frame.light_params = glm::vec4(0.25f, 0.5f, 32.0f, 0.0f);
+    UniformBuffer frame_uniforms = UniformBuffer(FRAME_UNIFORM_BINDING, sizeof(FrameUniforms));
+    frame_uniforms.update(&frame);
+
+    const char* names[] = {"per-vertex inverse(model)", "CPU normal matrix", "world space"};
+    const char* defines[] = {"#define PER_VERTEX_NORMAL_MATRIX\n", "", "#define WORLD_SPACE\n"};
+    double baseline = 0.0;
+    for (int i = 0; i < 3; i += 1) {
+        Shader shader = Shader("shaders/basic.vs", "shaders/basic.fs", defines[i]);
+        if (!shader.compile_shaders()) {
+            context.destroy();
+            return -1;
+        }
+
+        double ms = time_variant(shader, mesh, vertices.size());
+        if (i == 0) {
+            baseline = ms;
+        }
+        std::cout << names[i] << ": " << ms << " ms/frame, " << vertices.size() / (ms * 1000.0) << " Mvertices/s ("
+                  << baseline / ms << "x)" << std::endl;
+        glDeleteProgram(shader.getProgram());
+    }
+
+    context.destroy();
+    return 0;
+}
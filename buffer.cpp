@@ -0,0 +1,245 @@
+#ifdef __APPLE__
+    #include <OpenGL/gl3.h>
+#else
+    #include <OpenGL/gl.h>
+#endif
+
+#include <chrono>
+#include <cstring>
+
+#include "buffer.hpp"
+#include "trace.hpp"
+
+// The copy targets are used for every transfer so the element buffer binding of whatever VAO is bound is never touched.
+// Assigning less than a quarter of the capacity reallocates to fit, so storage shrinks back after churn.
+void GrowableBuffer::assign(const void* data, size_t size) {
+    if (size > this->capacity || size < this->capacity / 4) {
+        this->capacity = size;
+        glBindBuffer(GL_COPY_WRITE_BUFFER, this->getBuffer());
+        glBufferData(GL_COPY_WRITE_BUFFER, this->capacity, data, GL_DYNAMIC_DRAW);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+        this->size = size;
+        return;
+    }
+
+    this->size = 0;
+    this->append(data, size);
+}
+
+void GrowableBuffer::append(const void* data, size_t size) {
+    if (size == 0) {
+        return;
+    }
+
+    if (this->size + size > this->capacity) {
+        size_t capacity = this->capacity * 2;
+        if (capacity < this->size + size) {
+            capacity = this->size + size;
+        }
+        this->reserve(capacity);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, this->getBuffer());
+    glBufferSubData(GL_COPY_WRITE_BUFFER, this->size, size, data);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    this->size += size;
+}
+
+// Append bytes that already live in another GL buffer, copying them on the GPU timeline
+void GrowableBuffer::append_copy(unsigned int source, size_t offset, size_t size) {
+    if (size == 0) {
+        return;
+    }
+
+    if (this->size + size > this->capacity) {
+        size_t capacity = this->capacity * 2;
+        if (capacity < this->size + size) {
+            capacity = this->size + size;
+        }
+        this->reserve(capacity);
+    }
+
+    glBindBuffer(GL_COPY_READ_BUFFER, source);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, this->getBuffer());
+    glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, offset, this->size, size);
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    this->size += size;
+}
+
+void GrowableBuffer::reserve(size_t capacity) {
+    if (capacity <= this->capacity) {
+        return;
+    }
+    TRACE_ZONE("GrowableBuffer::reserve");
+
+    unsigned int buffer = this->getBuffer();
+
+    // Park the live bytes in a scratch buffer, reallocate in place and copy them back, all without a CPU round trip
+    unsigned int scratch = 0;
+    if (this->size > 0) {
+        glGenBuffers(1, &scratch);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, scratch);
+        glBufferData(GL_COPY_WRITE_BUFFER, this->size, NULL, GL_STREAM_COPY);
+        glBindBuffer(GL_COPY_READ_BUFFER, buffer);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, this->size);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    glBufferData(GL_COPY_WRITE_BUFFER, capacity, NULL, GL_DYNAMIC_DRAW);
+
+    if (scratch != 0) {
+        glBindBuffer(GL_COPY_READ_BUFFER, scratch);
+        glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, 0, this->size);
+        glDeleteBuffers(1, &scratch);
+    }
+
+    glBindBuffer(GL_COPY_READ_BUFFER, 0);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    this->capacity = capacity;
+}
+
+// The name is generated lazily because buffers can be declared before a GL context exists
+unsigned int GrowableBuffer::getBuffer() {
+    if (this->buffer == 0) {
+        glGenBuffers(1, &this->buffer);
+    }
+
+    return this->buffer;
+}
+
+size_t GrowableBuffer::getSize() {
+    return this->size;
+}
+
+size_t GrowableBuffer::getCapacity() {
+    return this->capacity;
+}
+
+UniformBuffer::UniformBuffer(unsigned int binding, size_t size) {
+    this->binding = binding;
+    this->size = size;
+}
+
+// The whole block in one glBufferSubData
+void UniformBuffer::update(const void* data) {
+    if (this->buffer == 0) {
+        glGenBuffers(1, &this->buffer);
+        glBindBuffer(GL_UNIFORM_BUFFER, this->buffer);
+        glBufferData(GL_UNIFORM_BUFFER, this->size, nullptr, GL_DYNAMIC_DRAW);
+        glBindBufferBase(GL_UNIFORM_BUFFER, this->binding, this->buffer);
+    }
+
+    glBindBuffer(GL_UNIFORM_BUFFER, this->buffer);
+    glBufferSubData(GL_UNIFORM_BUFFER, 0, this->size, data);
+}
+
+unsigned int UniformBuffer::getBuffer() {
+    return this->buffer;
+}
+
+StreamBuffer::StreamBuffer(size_t section_size) {
+    this->section_size = section_size;
+}
+
+// Copy data into the current section and return its byte offset within getBuffer()
+size_t StreamBuffer::write(const void* data, size_t size) {
+    if (this->buffer == 0) {
+        this->create();
+    }
+
+    // Out of room in this frame's section: move on to the next one early
+    if (this->head + size > this->section_size) {
+        this->fence();
+    }
+
+    size_t offset = this->section * this->section_size + this->head;
+    if (this->persistent) {
+        memcpy(this->mapped + offset, data, size);
+    } else {
+        // The fences already guarantee the GPU is done with this range, so the driver must not synchronize either
+        glBindBuffer(GL_COPY_WRITE_BUFFER, this->buffer);
+        void* destination = glMapBufferRange(GL_COPY_WRITE_BUFFER, offset, size, GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_RANGE_BIT | GL_MAP_UNSYNCHRONIZED_BIT);
+        memcpy(destination, data, size);
+        glUnmapBuffer(GL_COPY_WRITE_BUFFER);
+        glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+    }
+
+    this->head += size;
+    return offset;
+}
+
+// Close the current section once every command reading it has been issued, then claim the next one
+void StreamBuffer::fence() {
+    if (this->buffer == 0 || this->head == 0) {
+        return;
+    }
+
+    this->fences[this->section] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    this->section = (this->section + 1) % STREAM_SECTIONS;
+    this->head = 0;
+    this->wait(this->section);
+}
+
+void StreamBuffer::create() {
+    size_t size = this->section_size * STREAM_SECTIONS;
+    glGenBuffers(1, &this->buffer);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, this->buffer);
+
+#ifdef __glad_h_
+    if (GLAD_GL_VERSION_4_4) {
+        GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+        glBufferStorage(GL_COPY_WRITE_BUFFER, size, NULL, flags);
+        this->mapped = (char*)glMapBufferRange(GL_COPY_WRITE_BUFFER, 0, size, flags);
+        this->persistent = this->mapped != nullptr;
+    }
+#endif
+
+    if (!this->persistent) {
+        glBufferData(GL_COPY_WRITE_BUFFER, size, NULL, GL_STREAM_DRAW);
+    }
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
+
+// Any wait that does not return immediately is a stall: the CPU outran the GPU by a whole ring
+void StreamBuffer::wait(int section) {
+    GLsync fence = this->fences[section];
+    if (fence == nullptr) {
+        return;
+    }
+
+    GLenum result = glClientWaitSync(fence, 0, 0);
+    if (result == GL_TIMEOUT_EXPIRED) {
+        TRACE_ZONE("StreamBuffer stall");
+        auto start = std::chrono::steady_clock::now();
+        while (result == GL_TIMEOUT_EXPIRED) {
+            result = glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, 1000000);
+        }
+        this->stalls += 1;
+        this->stall_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    }
+
+    glDeleteSync(fence);
+    this->fences[section] = nullptr;
+}
+
+unsigned int StreamBuffer::getBuffer() {
+    return this->buffer;
+}
+
+size_t StreamBuffer::getSectionSize() {
+    return this->section_size;
+}
+
+bool StreamBuffer::isPersistent() {
+    return this->persistent;
+}
+
+unsigned int StreamBuffer::getStalls() {
+    return this->stalls;
+}
+
+double StreamBuffer::getStallSeconds() {
+    return this->stall_seconds;
+}
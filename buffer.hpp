@@ -0,0 +1,71 @@
+#include <cstddef>
+#ifdef __APPLE__
+    #include <OpenGL/gl3.h>
+#else
+    #include <OpenGL/gl.h>
+#endif
+
+#ifndef BUFFER_H
+#define BUFFER_H
+
+// A GL buffer object that keeps its name while its storage grows, so VAOs that reference it stay valid.
+// Appends upload only the new bytes; growth doubles the capacity and copies the old contents on the GPU.
+// Only assign gives storage back.
+class GrowableBuffer {
+public:
+    void assign(const void* data, size_t size);
+    void append(const void* data, size_t size);
+    void append_copy(unsigned int source, size_t offset, size_t size);
+    void reserve(size_t capacity);
+    unsigned int getBuffer();
+    size_t getSize();
+    size_t getCapacity();
+private:
+    unsigned int buffer = 0;
+    size_t size = 0;
+    size_t capacity = 0;
+};
+
+// Fixed-size uniform block storage, bound to its binding point when first updated and never unbound.
+// Every program whose block is assigned that binding reads the same bytes.
+class UniformBuffer {
+public:
+    UniformBuffer(unsigned int binding, size_t size);
+    void update(const void* data);
+    unsigned int getBuffer();
+private:
+    unsigned int buffer = 0;
+    unsigned int binding;
+    size_t size;
+};
+
+const int STREAM_SECTIONS = 3;
+
+// Triple-buffered staging ring for per-frame uploads. Each frame writes into its own section of a mapped buffer,
+// and a fence per section keeps the CPU from overwriting bytes the GPU has not consumed yet.
+// Uses a persistent coherent mapping when GL 4.4 is available, otherwise unsynchronized glMapBufferRange.
+class StreamBuffer {
+public:
+    StreamBuffer(size_t section_size);
+    size_t write(const void* data, size_t size);
+    void fence();
+    unsigned int getBuffer();
+    size_t getSectionSize();
+    bool isPersistent();
+    unsigned int getStalls();
+    double getStallSeconds();
+private:
+    void create();
+    void wait(int section);
+    unsigned int buffer = 0;
+    char* mapped = nullptr;
+    bool persistent = false;
+    size_t section_size;
+    int section = 0;
+    size_t head = 0;
+    GLsync fences[STREAM_SECTIONS] = {};
+    unsigned int stalls = 0;
+    double stall_seconds = 0.0;
+};
+
+#endif
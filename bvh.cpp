@@ -0,0 +1,499 @@
+#include <cmath>
+#include <algorithm>
+#include <limits>
+#include <queue>
+#include <functional>
+
+#include "bvh.hpp"
+#include "trace.hpp"
+
+// Centroids are sorted into this many bins per axis when looking for the cheapest split
+static const int BINS = 16;
+
+// Walk stacks hold the far child of every inner node on the way down, one per level
+static const int STACK_SIZE = BVH_MAX_DEPTH + 2;
+
+// Half the surface area, which is all the heuristic needs since only ratios matter
+static float half_area(const glm::vec3& min, const glm::vec3& max) {
+    glm::vec3 extent = max - min;
+    return extent.x * extent.y + extent.y * extent.z + extent.z * extent.x;
+}
+
+static bool overlaps(const BvhNode& node, const Bounds& bounds) {
+    return node.min.x <= bounds.max.x && node.max.x >= bounds.min.x && node.min.y <= bounds.max.y && node.max.y >= bounds.min.y
+        && node.min.z <= bounds.max.z && node.max.z >= bounds.min.z;
+}
+
+static bool overlaps(const Bounds& a, const Bounds& b) {
+    return a.min.x <= b.max.x && a.max.x >= b.min.x && a.min.y <= b.max.y && a.max.y >= b.min.y && a.min.z <= b.max.z && a.max.z >= b.min.z;
+}
+
+// Zero inside the box
+static float distance_to(const glm::vec3& min, const glm::vec3& max, const glm::vec3& point) {
+    glm::vec3 outside = glm::max(glm::max(min - point, point - max), glm::vec3(0.0f));
+    return glm::length(outside);
+}
+
+// Slab test for walking the tree: where the ray up to max_distance enters the node, if it does. Like clip_ray, a NaN
+// from a ray running along a face is ignored, which can only let a node through, never skip one.
+static inline bool enters(const BvhNode& node, const glm::vec3& origin, const glm::vec3& inverse_direction, float max_distance, float& enter) {
+    float low = 0.0f;
+    float high = max_distance;
+    for (int a = 0; a < 3; a += 1) {
+        float t0 = (node.min[a] - origin[a]) * inverse_direction[a];
+        float t1 = (node.max[a] - origin[a]) * inverse_direction[a];
+        float near = inverse_direction[a] < 0.0f ? t1 : t0;
+        float far = inverse_direction[a] < 0.0f ? t0 : t1;
+        low = near > low ? near : low;
+        high = far < high ? far : high;
+    }
+    enter = low;
+    return low <= high;
+}
+
+void Bvh::build(const std::vector<Bounds>& objects) {
+    TRACE_ZONE("Bvh::build");
+    this->objects = objects;
+    this->indices.resize(objects.size());
+    this->nodes.clear();
+    if (objects.empty()) {
+        return;
+    }
+
+    // A binary tree over n leaves never needs more than 2n - 1 nodes, so the array is not reallocated mid-build
+    std::vector<glm::vec3> centers(objects.size());
+    for (size_t i = 0; i < objects.size(); i += 1) {
+        this->indices[i] = i;
+        centers[i] = (objects[i].min + objects[i].max) * 0.5f;
+    }
+    this->nodes.reserve(2 * objects.size() - 1);
+    BvhNode root;
+    root.first = 0;
+    root.count = objects.size();
+    this->fit(root);
+    this->nodes.push_back(root);
+
+    std::vector<std::pair<uint32_t, int>> pending = {{0, 0}};
+    while (!pending.empty()) {
+        uint32_t node = pending.back().first;
+        int depth = pending.back().second;
+        pending.pop_back();
+        if (depth < BVH_MAX_DEPTH && this->subdivide(node, centers)) {
+            pending.push_back({this->nodes[node].first, depth + 1});
+            pending.push_back({this->nodes[node].first + 1, depth + 1});
+        }
+    }
+}
+
+// Splits a leaf in two where the surface area heuristic says it pays: a split costs one more box test plus each
+// side's object count weighted by how likely a ray through the parent is to hit that side. Returns false to keep the leaf.
+bool Bvh::subdivide(uint32_t index, const std::vector<glm::vec3>& centers) {
+    BvhNode& node = this->nodes[index];
+    float parent_area = half_area(node.min, node.max);
+    if (node.count <= 1 || parent_area <= 0.0f) {
+        return false;
+    }
+
+    glm::vec3 center_min = centers[this->indices[node.first]];
+    glm::vec3 center_max = center_min;
+    for (uint32_t i = node.first; i < node.first + node.count; i += 1) {
+        center_min = glm::min(center_min, centers[this->indices[i]]);
+        center_max = glm::max(center_max, centers[this->indices[i]]);
+    }
+
+    float best_cost = node.count;
+    int best_axis = -1;
+    int best_split = 0;
+    for (int axis = 0; axis < 3; axis += 1) {
+        float extent = center_max[axis] - center_min[axis];
+        if (extent <= 0.0f) {
+            continue;
+        }
+
+        int counts[BINS] = {};
+        glm::vec3 mins[BINS], maxs[BINS];
+        float scale = BINS / extent;
+        for (uint32_t i = node.first; i < node.first + node.count; i += 1) {
+            uint32_t object = this->indices[i];
+            int bin = std::min(BINS - 1, (int)((centers[object][axis] - center_min[axis]) * scale));
+            const Bounds& bounds = this->objects[object];
+            mins[bin] = counts[bin] == 0 ? bounds.min : glm::min(mins[bin], bounds.min);
+            maxs[bin] = counts[bin] == 0 ? bounds.max : glm::max(maxs[bin], bounds.max);
+            counts[bin] += 1;
+        }
+
+        // Sweep from the left for every split's left side and from the right for its right side
+        float left_cost[BINS];
+        int left = 0;
+        glm::vec3 low, high;
+        for (int bin = 0; bin < BINS - 1; bin += 1) {
+            if (counts[bin] > 0) {
+                low = left == 0 ? mins[bin] : glm::min(low, mins[bin]);
+                high = left == 0 ? maxs[bin] : glm::max(high, maxs[bin]);
+                left += counts[bin];
+            }
+            left_cost[bin] = left == 0 ? 0.0f : left * half_area(low, high);
+        }
+        int right = 0;
+        for (int bin = BINS - 1; bin > 0; bin -= 1) {
+            if (counts[bin] > 0) {
+                low = right == 0 ? mins[bin] : glm::min(low, mins[bin]);
+                high = right == 0 ? maxs[bin] : glm::max(high, maxs[bin]);
+                right += counts[bin];
+            }
+            float cost = 1.0f + (left_cost[bin - 1] + (right == 0 ? 0.0f : right * half_area(low, high))) / parent_area;
+            if (cost < best_cost) {
+                best_cost = cost;
+                best_axis = axis;
+                best_split = bin;
+            }
+        }
+    }
+    if (best_axis < 0) {
+        return false;
+    }
+
+    // Partition the leaf's objects in place, those left of the split first
+    float scale = BINS / (center_max[best_axis] - center_min[best_axis]);
+    uint32_t i = node.first;
+    uint32_t j = node.first + node.count;
+    while (i < j) {
+        int bin = std::min(BINS - 1, (int)((centers[this->indices[i]][best_axis] - center_min[best_axis]) * scale));
+        if (bin < best_split) {
+            i += 1;
+        } else {
+            j -= 1;
+            std::swap(this->indices[i], this->indices[j]);
+        }
+    }
+    uint32_t left_count = i - node.first;
+    if (left_count == 0 || left_count == node.count) {
+        return false;
+    }
+
+    BvhNode children[2];
+    children[0].first = node.first;
+    children[0].count = left_count;
+    children[1].first = i;
+    children[1].count = node.count - left_count;
+    for (BvhNode& child : children) {
+        this->fit(child);
+    }
+    node.first = this->nodes.size();
+    node.count = 0;
+    this->nodes.push_back(children[0]);
+    this->nodes.push_back(children[1]);
+    return true;
+}
+
+// Bounds of a leaf's objects
+void Bvh::fit(BvhNode& node) {
+    node.min = this->objects[this->indices[node.first]].min;
+    node.max = this->objects[this->indices[node.first]].max;
+    for (uint32_t i = node.first + 1; i < node.first + node.count; i += 1) {
+        node.min = glm::min(node.min, this->objects[this->indices[i]].min);
+        node.max = glm::max(node.max, this->objects[this->indices[i]].max);
+    }
+}
+
+// Pairs the box with the leaf that makes the tree cheapest: the area of the new inner node plus how much every node
+// above it grows. A branch and bound search finds it, skipping subtrees whose growth alone already costs more than
+// the best leaf so far. Greedily descending into the child that grows least would instead keep following the nodes
+// above a box as big as the ground, which contain everything and never grow. Returns the box's object index.
+uint32_t Bvh::insert(const Bounds& bounds) {
+    uint32_t object = this->objects.size();
+    this->objects.push_back(bounds);
+    this->indices.push_back(object);
+
+    BvhNode leaf;
+    leaf.min = bounds.min;
+    leaf.max = bounds.max;
+    leaf.first = this->indices.size() - 1;
+    leaf.count = 1;
+    if (this->nodes.empty()) {
+        this->nodes.push_back(leaf);
+        return object;
+    }
+
+    // Every node searched, with the one above it, so the way back up from the chosen leaf is known
+    struct Visit {
+        uint32_t node;
+        int parent;
+        float inherited; // growth of the nodes above
+    };
+    std::vector<Visit> visited;
+    // Cheapest lower bound first, so a good leaf is found early and most of the tree is skipped
+    std::priority_queue<std::pair<float, int>, std::vector<std::pair<float, int>>, std::greater<std::pair<float, int>>> pending;
+    pending.push({0.0f, 0});
+    visited.push_back({0, -1, 0.0f});
+    float area = half_area(bounds.min, bounds.max);
+    float best_cost = std::numeric_limits<float>::infinity();
+    int best = -1;
+    while (!pending.empty() && pending.top().first < best_cost) {
+        int current = pending.top().second;
+        Visit visit = visited[current];
+        pending.pop();
+        const BvhNode& node = this->nodes[visit.node];
+        float combined = half_area(glm::min(node.min, bounds.min), glm::max(node.max, bounds.max));
+        if (node.count > 0) {
+            if (combined + visit.inherited < best_cost) {
+                best_cost = combined + visit.inherited;
+                best = current;
+            }
+            continue;
+        }
+        float inherited = visit.inherited + combined - half_area(node.min, node.max);
+        if (area + inherited < best_cost) {
+            for (int side = 0; side < 2; side += 1) {
+                pending.push({area + inherited, (int)visited.size()});
+                visited.push_back({node.first + (uint32_t)side, current, inherited});
+            }
+        }
+    }
+
+    int depth = 0;
+    for (int i = visited[best].parent; i >= 0; i = visited[i].parent) {
+        BvhNode& node = this->nodes[visited[i].node];
+        node.min = glm::min(node.min, bounds.min);
+        node.max = glm::max(node.max, bounds.max);
+        depth += 1;
+    }
+
+    // A run of inserts in one place can still grow a long chain; start over from a fresh split instead
+    if (depth >= BVH_MAX_DEPTH) {
+        std::vector<Bounds> objects;
+        objects.swap(this->objects);
+        this->build(objects);
+        return object;
+    }
+
+    // The old leaf moves to the end of the array so children still come after their parent
+    uint32_t index = visited[best].node;
+    BvhNode old = this->nodes[index];
+    BvhNode& node = this->nodes[index];
+    node.min = glm::min(old.min, bounds.min);
+    node.max = glm::max(old.max, bounds.max);
+    node.first = this->nodes.size();
+    node.count = 0;
+    this->nodes.push_back(old);
+    this->nodes.push_back(leaf);
+    return object;
+}
+
+// Adds boxes in order, one search each while the batch is small next to the tree, else splitting everything afresh,
+// which is both quicker for a big batch and gives a better tree
+void Bvh::insert(const std::vector<Bounds>& objects) {
+    if (objects.size() * 8 < this->objects.size()) {
+        for (const Bounds& bounds : objects) {
+            this->insert(bounds);
+        }
+        return;
+    }
+
+    std::vector<Bounds> all;
+    all.swap(this->objects);
+    all.insert(all.end(), objects.begin(), objects.end());
+    this->build(all);
+}
+
+// Takes effect on the next refit()
+void Bvh::update(uint32_t object, const Bounds& bounds) {
+    this->objects[object] = bounds;
+}
+
+// Children always come after their parent, so a single backwards pass sees every child before the node above it
+void Bvh::refit() {
+    TRACE_ZONE("Bvh::refit");
+    for (size_t i = this->nodes.size(); i-- > 0; ) {
+        BvhNode& node = this->nodes[i];
+        if (node.count > 0) {
+            this->fit(node);
+        } else {
+            const BvhNode& left = this->nodes[node.first];
+            const BvhNode& right = this->nodes[node.first + 1];
+            node.min = glm::min(left.min, right.min);
+            node.max = glm::max(left.max, right.max);
+        }
+    }
+}
+
+// Nearest box the ray enters within max_distance, visiting the nearer child first and skipping any node
+// that starts beyond the nearest hit so far. A ray starting inside a box does not hit it.
+bool Bvh::raycast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, RayHit& hit, uint32_t& object) const {
+    if (this->nodes.empty()) {
+        return false;
+    }
+
+    glm::vec3 inverse_direction = 1.0f / direction;
+    float nearest = max_distance;
+    int nearest_axis = -1;
+    float enter, leave;
+    int axis;
+    if (!enters(this->nodes[0], origin, inverse_direction, nearest, enter)) {
+        return false;
+    }
+
+    uint32_t stack[STACK_SIZE];
+    float stack_enter[STACK_SIZE];
+    int size = 0;
+    stack[size] = 0;
+    stack_enter[size] = enter;
+    size += 1;
+    while (size > 0) {
+        size -= 1;
+        if (stack_enter[size] > nearest) {
+            continue;
+        }
+        const BvhNode& node = this->nodes[stack[size]];
+
+        if (node.count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; i += 1) {
+                if (clip_ray(this->objects[this->indices[i]], origin, inverse_direction, nearest, enter, leave, axis) && axis >= 0) {
+                    nearest = enter;
+                    nearest_axis = axis;
+                    object = this->indices[i];
+                }
+            }
+            continue;
+        }
+
+        float child_enter[2];
+        bool child_hit[2];
+        for (int side = 0; side < 2; side += 1) {
+            child_hit[side] = enters(this->nodes[node.first + side], origin, inverse_direction, nearest, child_enter[side]);
+        }
+        int near = child_enter[1] < child_enter[0] ? 1 : 0;
+        for (int side : {1 - near, near}) {
+            if (child_hit[side]) {
+                stack[size] = node.first + side;
+                stack_enter[size] = child_enter[side];
+                size += 1;
+            }
+        }
+    }
+
+    if (nearest_axis < 0) {
+        return false;
+    }
+    set_box_hit(origin, direction, nearest, nearest_axis, hit);
+    return true;
+}
+
+// Appends every box that touches bounds
+void Bvh::overlap(const Bounds& bounds, std::vector<uint32_t>& objects) const {
+    if (this->nodes.empty()) {
+        return;
+    }
+
+    uint32_t stack[STACK_SIZE];
+    int size = 0;
+    stack[size++] = 0;
+    while (size > 0) {
+        const BvhNode& node = this->nodes[stack[--size]];
+        if (!overlaps(node, bounds)) {
+            continue;
+        }
+
+        if (node.count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; i += 1) {
+                if (overlaps(this->objects[this->indices[i]], bounds)) {
+                    objects.push_back(this->indices[i]);
+                }
+            }
+        } else {
+            stack[size++] = node.first;
+            stack[size++] = node.first + 1;
+        }
+    }
+}
+
+// Appends every box containing point
+void Bvh::overlap(const glm::vec3& point, std::vector<uint32_t>& objects) const {
+    this->overlap(Bounds{point, point}, objects);
+}
+
+// Box closest to point within max_distance, zero if the point is inside one. Nodes are visited nearer child first
+// and skipped once they lie farther than the best box so far.
+bool Bvh::nearest(const glm::vec3& point, float max_distance, uint32_t& object, float& distance) const {
+    if (this->nodes.empty()) {
+        return false;
+    }
+
+    float best = max_distance;
+    bool found = false;
+    uint32_t stack[STACK_SIZE];
+    float stack_distance[STACK_SIZE];
+    int size = 0;
+    stack[size] = 0;
+    stack_distance[size] = distance_to(this->nodes[0].min, this->nodes[0].max, point);
+    size += 1;
+    while (size > 0) {
+        size -= 1;
+        if (stack_distance[size] > best) {
+            continue;
+        }
+        const BvhNode& node = this->nodes[stack[size]];
+
+        if (node.count > 0) {
+            for (uint32_t i = node.first; i < node.first + node.count; i += 1) {
+                const Bounds& bounds = this->objects[this->indices[i]];
+                float d = distance_to(bounds.min, bounds.max, point);
+                if (d <= best) {
+                    best = d;
+                    object = this->indices[i];
+                    found = true;
+                }
+            }
+            continue;
+        }
+
+        float child_distance[2];
+        for (int side = 0; side < 2; side += 1) {
+            const BvhNode& child = this->nodes[node.first + side];
+            child_distance[side] = distance_to(child.min, child.max, point);
+        }
+        int near = child_distance[1] < child_distance[0] ? 1 : 0;
+        for (int side : {1 - near, near}) {
+            if (child_distance[side] <= best) {
+                stack[size] = node.first + side;
+                stack_distance[size] = child_distance[side];
+                size += 1;
+            }
+        }
+    }
+
+    distance = best;
+    return found;
+}
+
+const Bounds& Bvh::getBounds(uint32_t object) const {
+    return this->objects[object];
+}
+
+size_t Bvh::getObjectCount() const {
+    return this->objects.size();
+}
+
+size_t Bvh::getNodeCount() const {
+    return this->nodes.size();
+}
+
+// Deepest leaf, counting the root as depth 0
+int Bvh::getDepth() const {
+    int deepest = 0;
+    std::vector<std::pair<uint32_t, int>> pending;
+    if (!this->nodes.empty()) {
+        pending.push_back({0, 0});
+    }
+    while (!pending.empty()) {
+        uint32_t index = pending.back().first;
+        int depth = pending.back().second;
+        pending.pop_back();
+        deepest = std::max(deepest, depth);
+        if (this->nodes[index].count == 0) {
+            pending.push_back({this->nodes[index].first, depth + 1});
+            pending.push_back({this->nodes[index].first + 1, depth + 1});
+        }
+    }
+    return deepest;
+}
@@ -0,0 +1,48 @@
+#include <vector>
+#include <cstdint>
+#include "glm/glm/glm.hpp"
+#include "frustum.hpp"
+#include "raycast.hpp"
+
+#ifndef BVH_H
+#define BVH_H
+
+// Queries walk the tree with a fixed stack, so build() stops splitting and insert() rebuilds at this depth
+const int BVH_MAX_DEPTH = 48;
+
+// One node of the flattened tree, 32 bytes so two share a cache line. An inner node's children are nodes first and
+// first + 1, always after it in the array; a leaf holds the objects indices[first] to indices[first + count - 1].
+struct BvhNode {
+    glm::vec3 min;
+    uint32_t first;
+    glm::vec3 max;
+    uint32_t count; // 0 for inner nodes
+};
+
+// Bounding volume hierarchy over axis-aligned boxes, identified by the order they were added in.
+// build() splits with a binned surface area heuristic. insert() adds one box to the existing tree and grows the
+// nodes above it; update() moves a box and refit() recomputes every node's bounds afterwards, keeping the splits.
+class Bvh {
+public:
+    void build(const std::vector<Bounds>& objects);
+    uint32_t insert(const Bounds& bounds);
+    void insert(const std::vector<Bounds>& objects);
+    void update(uint32_t object, const Bounds& bounds);
+    void refit();
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, RayHit& hit, uint32_t& object) const;
+    void overlap(const Bounds& bounds, std::vector<uint32_t>& objects) const;
+    void overlap(const glm::vec3& point, std::vector<uint32_t>& objects) const;
+    bool nearest(const glm::vec3& point, float max_distance, uint32_t& object, float& distance) const;
+    const Bounds& getBounds(uint32_t object) const;
+    size_t getObjectCount() const;
+    size_t getNodeCount() const;
+    int getDepth() const;
+private:
+    bool subdivide(uint32_t node, const std::vector<glm::vec3>& centers);
+    void fit(BvhNode& node);
+    std::vector<BvhNode> nodes;
+    std::vector<uint32_t> indices;
+    std::vector<Bounds> objects;
+};
+
+#endif
@@ -40,6 +40,8 @@ public:
     glm::vec3 Up;
     glm::vec3 Right;
     glm::vec3 WorldUp;
+    // movement from input since the last takeMovement(), on the ground plane
+    glm::vec3 Movement;
     // euler Angles
     float Yaw;
     float Pitch;
@@ -49,7 +51,7 @@ public:
     float Zoom;
 
     // constructor with vectors
-    Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
+    Camera(glm::vec3 position = glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3 up = glm::vec3(0.0f, 1.0f, 0.0f), float yaw = YAW, float pitch = PITCH) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), Movement(glm::vec3(0.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
     {
         Position = position;
         WorldUp = up;
@@ -58,7 +60,7 @@ public:
         updateCameraVectors();
     }
     // constructor with scalar values
-    Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
+    Camera(float posX, float posY, float posZ, float upX, float upY, float upZ, float yaw, float pitch) : Front(glm::vec3(0.0f, 0.0f, -1.0f)), Movement(glm::vec3(0.0f)), MovementSpeed(SPEED), MouseSensitivity(SENSITIVITY), Zoom(ZOOM)
     {
         Position = glm::vec3(posX, posY, posZ);
         WorldUp = glm::vec3(upX, upY, upZ);
@@ -74,21 +76,28 @@ public:
     }
 
     // processes input received from any keyboard-like input system. Accepts input parameter in the form of camera defined ENUM (to abstract it from windowing systems)
+    // The camera walks at a fixed height, so only the horizontal part of Front is kept. Nothing moves until the
+    // caller takes the movement, which lets it collide the move with the world first.
     void processKeyboard(Camera_Movement direction, float deltaTime)
     {
         float velocity = MovementSpeed * deltaTime;
-        if (direction == FORWARD) {
-            Position += Front * velocity;
-            Position.y = 2;
-        }
-        if (direction == BACKWARD) {
-            Position -= Front * velocity;
-            Position.y = 2;
-        }
+        glm::vec3 forward = glm::vec3(Front.x, 0.0f, Front.z);
+        if (direction == FORWARD)
+            Movement += forward * velocity;
+        if (direction == BACKWARD)
+            Movement -= forward * velocity;
         if (direction == LEFT)
-            Position -= Right * velocity;
+            Movement -= Right * velocity;
         if (direction == RIGHT)
-            Position += Right * velocity;
+            Movement += Right * velocity;
+    }
+
+    // returns the movement collected by processKeyboard and starts over
+    glm::vec3 takeMovement()
+    {
+        glm::vec3 movement = Movement;
+        Movement = glm::vec3(0.0f);
+        return movement;
     }
 
     // processes input received from a mouse input system. Expects the offset value in both the x and y direction.
@@ -131,6 +140,14 @@ public:
         this->MovementSpeed = speed;
     }
 
+    // places the camera directly, for scripted paths that bypass input
+    void setPose(glm::vec3 position, float yaw, float pitch) {
+        this->Position = position;
+        this->Yaw = yaw;
+        this->Pitch = pitch;
+        updateCameraVectors();
+    }
+
 private:
     // calculates the front vector from the Camera's (updated) Euler Angles
     void updateCameraVectors()
@@ -0,0 +1,45 @@
+#include <cmath>
+
+#include "collision.hpp"
+#include "raycast.hpp"
+
+// Sweeping a box is casting a ray from its center against every obstacle grown by the box's half size
+glm::vec3 sweep(const Bounds& body, const glm::vec3& movement, const std::vector<Bounds>& obstacles) {
+    glm::vec3 center = (body.min + body.max) * 0.5f;
+    glm::vec3 half = (body.max - body.min) * 0.5f;
+    glm::vec3 moved = glm::vec3(0.0f);
+    glm::vec3 remaining = movement;
+
+    for (int pass = 0; pass < 3; pass += 1) {
+        float length = glm::length(remaining);
+        if (length <= 0.0f) {
+            break;
+        }
+        glm::vec3 direction = remaining / length;
+        glm::vec3 inverse_direction = 1.0f / direction;
+        glm::vec3 origin = center + moved;
+
+        float nearest = length;
+        int nearest_axis = -1;
+        for (const Bounds& obstacle : obstacles) {
+            Bounds grown = {obstacle.min - half, obstacle.max + half};
+            float enter, leave;
+            int axis;
+            if (clip_ray(grown, origin, inverse_direction, nearest, enter, leave, axis) && axis >= 0) {
+                nearest = enter;
+                nearest_axis = axis;
+            }
+        }
+        if (nearest_axis < 0) {
+            moved += remaining;
+            break;
+        }
+
+        // Stop at the face, backed off along its normal, and keep only the movement along the face
+        moved += direction * nearest;
+        moved[nearest_axis] -= direction[nearest_axis] > 0.0f ? COLLISION_SKIN : -COLLISION_SKIN;
+        remaining = direction * (length - nearest);
+        remaining[nearest_axis] = 0.0f;
+    }
+    return moved;
+}
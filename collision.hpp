@@ -0,0 +1,16 @@
+#include <vector>
+#include "glm/glm/glm.hpp"
+#include "frustum.hpp"
+
+#ifndef COLLISION_H
+#define COLLISION_H
+
+// Gap a moving box keeps from whatever stopped it, so its next move starts clear of the obstacle
+const float COLLISION_SKIN = 0.001f;
+
+// Swept AABB: moves body along movement until it first touches an obstacle, then slides along that obstacle's face
+// with what is left of the movement, at most once per axis. Returns the movement actually made. Obstacles the body
+// already overlaps are ignored, so a box that appears around it can still be walked out of.
+glm::vec3 sweep(const Bounds& body, const glm::vec3& movement, const std::vector<Bounds>& obstacles);
+
+#endif
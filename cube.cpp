@@ -0,0 +1,119 @@
+#include <algorithm>
+
+#include "cube.hpp"
+#include "trace.hpp"
+
+// Writes the 36 vertices of a box to out
+void write_cube(CubeSize size, Origin origin, Color color, Vertex* out) {
+    const Vertex vertices[] = {
+        // Front
+        { origin.x + size.x / 2,  origin.y + size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, 1.0f, },
+        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, 1.0f, },
+        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, 1.0f, },
+        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, 1.0f, },
+        { origin.x - size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, 1.0f, },
+        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, 1.0f, },
+        // Back
+        { origin.x + size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, -1.0f, },
+        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, -1.0f, },
+        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, -1.0f, },
+        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, -1.0f, },
+        { origin.x - size.x / 2,  origin.y - size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, -1.0f, },
+        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, -1.0f, },
+        // Top
+        { origin.x + size.x / 2,  origin.y + size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 1.0f, 0.0f, },
+        { origin.x + size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 1.0f, 0.0f, },
+        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 1.0f, 0.0f, },
+        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 1.0f, 0.0f, },
+        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 1.0f, 0.0f, },
+        { origin.x + size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 1.0f, 0.0f, },
+        // Bottom
+        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, -1.0f, 0.0f, },
+        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, -1.0f, 0.0f, },
+        { origin.x - size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, -1.0f, 0.0f, },
+        { origin.x - size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, -1.0f, 0.0f, },
+        { origin.x - size.x / 2,  origin.y - size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, -1.0f, 0.0f, },
+        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, -1.0f, 0.0f, },
+        // Left
+        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, -1.0f, 0.0f, 0.0f, },
+        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, -1.0f, 0.0f, 0.0f, },
+        { origin.x - size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, -1.0f, 0.0f, 0.0f, },
+        { origin.x - size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, -1.0f, 0.0f, 0.0f, },
+        { origin.x - size.x / 2,  origin.y - size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, -1.0f, 0.0f, 0.0f, },
+        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, -1.0f, 0.0f, 0.0f, },
+        // Right
+        { origin.x + size.x / 2,  origin.y + size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 1.0f,  0.0f, 0.0f, },
+        { origin.x + size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 1.0f,  0.0f, 0.0f, },
+        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 1.0f,  0.0f, 0.0f, },
+        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 1.0f,  0.0f, 0.0f, },
+        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 1.0f,  0.0f, 0.0f, },
+        { origin.x + size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 1.0f,  0.0f, 0.0f, },
+    };
+
+    std::copy(vertices, vertices + 36, out);
+}
+
+// Shared-corner variant of write_cube: writes 4 vertices per face to out, drawn with write_cube_indices
+void write_indexed_cube(CubeSize size, Origin origin, Color color, Vertex* out) {
+    const Vertex vertices[] = {
+        // Front
+        { origin.x + size.x / 2,  origin.y + size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, 1.0f, },
+        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, 1.0f, },
+        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, 1.0f, },
+        { origin.x - size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, 1.0f, },
+        // Back
+        { origin.x + size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, -1.0f, },
+        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, -1.0f, },
+        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, -1.0f, },
+        { origin.x - size.x / 2,  origin.y - size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, -1.0f, },
+        // Top
+        { origin.x + size.x / 2,  origin.y + size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 1.0f, 0.0f, },
+        { origin.x + size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 1.0f, 0.0f, },
+        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 1.0f, 0.0f, },
+        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 1.0f, 0.0f, },
+        // Bottom
+        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, -1.0f, 0.0f, },
+        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, -1.0f, 0.0f, },
+        { origin.x - size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, -1.0f, 0.0f, },
+        { origin.x - size.x / 2,  origin.y - size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, -1.0f, 0.0f, },
+        // Left
+        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, -1.0f, 0.0f, 0.0f, },
+        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, -1.0f, 0.0f, 0.0f, },
+        { origin.x - size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, -1.0f, 0.0f, 0.0f, },
+        { origin.x - size.x / 2,  origin.y - size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, -1.0f, 0.0f, 0.0f, },
+        // Right
+        { origin.x + size.x / 2,  origin.y + size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 1.0f,  0.0f, 0.0f, },
+        { origin.x + size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 1.0f,  0.0f, 0.0f, },
+        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 1.0f,  0.0f, 0.0f, },
+        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 1.0f,  0.0f, 0.0f, },
+    };
+
+    std::copy(vertices, vertices + 24, out);
+}
+
+// Writes the 36 indices of two triangles per face of write_indexed_cube, offset by the cube's first vertex
+void write_cube_indices(unsigned int base, unsigned int* out) {
+    write_quad_indices(base, 6, out);
+}
+
+// Two triangles for each of quads consecutive 4-vertex faces starting at vertex base
+void write_quad_indices(unsigned int base, int quads, unsigned int* out) {
+    for (int quad = 0; quad < quads; quad += 1) {
+        unsigned int corner = base + quad * 4;
+        unsigned int triangles[] = {corner, corner + 1, corner + 2, corner + 1, corner + 3, corner + 2};
+        std::copy(triangles, triangles + 6, out + quad * 6);
+    }
+}
+
+std::vector<Vertex> create_indexed_cube(CubeSize size, Origin origin, Color color) {
+    TRACE_ZONE("create_indexed_cube");
+    std::vector<Vertex> vertices(24);
+    write_indexed_cube(size, origin, color, vertices.data());
+    return vertices;
+}
+
+std::vector<unsigned int> create_cube_indices(unsigned int base) {
+    std::vector<unsigned int> indices(36);
+    write_cube_indices(base, indices.data());
+    return indices;
+}
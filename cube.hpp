@@ -0,0 +1,31 @@
+#include <vector>
+#include "vertex.hpp"
+
+#ifndef CUBE_H
+#define CUBE_H
+
+struct CubeSize {
+    float x, y, z;
+};
+
+struct Origin {
+    float x, y, z;
+};
+
+struct Color {
+    float r, g, b;
+};
+
+const int CUBE_VERTICES = 36;
+const int INDEXED_CUBE_VERTICES = 24;
+const int CUBE_INDICES = 36;
+
+// write_* fill caller-provided storage, so bulk generation can write straight into pre-sized buffers
+void write_cube(CubeSize size, Origin origin, Color color, Vertex* out);
+void write_indexed_cube(CubeSize size, Origin origin, Color color, Vertex* out);
+void write_cube_indices(unsigned int base, unsigned int* out);
+void write_quad_indices(unsigned int base, int quads, unsigned int* out);
+std::vector<Vertex> create_indexed_cube(CubeSize size, Origin origin, Color color);
+std::vector<unsigned int> create_cube_indices(unsigned int base);
+
+#endif
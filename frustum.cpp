@@ -0,0 +1,163 @@
+#ifdef __SSE2__
+    #include <immintrin.h>
+#endif
+
+#include "frustum.hpp"
+
+void BoundsArray::push_back(const Bounds& bounds) {
+    this->min_x.push_back(bounds.min.x);
+    this->min_y.push_back(bounds.min.y);
+    this->min_z.push_back(bounds.min.z);
+    this->max_x.push_back(bounds.max.x);
+    this->max_y.push_back(bounds.max.y);
+    this->max_z.push_back(bounds.max.z);
+}
+
+Bounds BoundsArray::get(size_t i) const {
+    Bounds bounds;
+    bounds.min = glm::vec3(this->min_x[i], this->min_y[i], this->min_z[i]);
+    bounds.max = glm::vec3(this->max_x[i], this->max_y[i], this->max_z[i]);
+    return bounds;
+}
+
+size_t BoundsArray::size() const {
+    return this->min_x.size();
+}
+
+void BoundsArray::clear() {
+    this->min_x.clear();
+    this->min_y.clear();
+    this->min_z.clear();
+    this->max_x.clear();
+    this->max_y.clear();
+    this->max_z.clear();
+}
+
+// Gribb/Hartmann: each plane is the sum or difference of the matrix's last row and one of the others
+Frustum::Frustum(const glm::mat4& view_projection) {
+    glm::vec4 rows[4];
+    for (int i = 0; i < 4; i += 1) {
+        rows[i] = glm::vec4(view_projection[0][i], view_projection[1][i], view_projection[2][i], view_projection[3][i]);
+    }
+
+    this->planes[0] = rows[3] + rows[0]; // Left
+    this->planes[1] = rows[3] - rows[0]; // Right
+    this->planes[2] = rows[3] + rows[1]; // Bottom
+    this->planes[3] = rows[3] - rows[1]; // Top
+    this->planes[4] = rows[3] + rows[2]; // Near
+    this->planes[5] = rows[3] - rows[2]; // Far
+
+    for (int i = 0; i < 6; i += 1) {
+        this->planes[i] /= glm::length(glm::vec3(this->planes[i]));
+    }
+}
+
+// A box is outside when its corner furthest along a plane's normal is still behind that plane
+bool Frustum::intersects(const Bounds& bounds) const {
+    for (int i = 0; i < 6; i += 1) {
+        const glm::vec4& plane = this->planes[i];
+        glm::vec3 corner = glm::vec3(plane.x >= 0.0f ? bounds.max.x : bounds.min.x,
+                                     plane.y >= 0.0f ? bounds.max.y : bounds.min.y,
+                                     plane.z >= 0.0f ? bounds.max.z : bounds.min.z);
+        if (glm::dot(glm::vec3(plane), corner) + plane.w < 0.0f) {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+void Frustum::test(const BoundsArray& bounds, unsigned char* visible) const {
+#if defined(__AVX__)
+    this->test_avx(bounds, visible);
+#elif defined(__SSE2__)
+    this->test_sse(bounds, visible);
+#else
+    this->test_scalar(bounds, 0, visible);
+#endif
+}
+
+// Boxes from first onwards, one at a time; also finishes the tail the SIMD kernels leave over
+void Frustum::test_scalar(const BoundsArray& bounds, size_t first, unsigned char* visible) const {
+    for (size_t i = first; i < bounds.size(); i += 1) {
+        bool inside = true;
+        for (int p = 0; p < 6 && inside; p += 1) {
+            const glm::vec4& plane = this->planes[p];
+            float x = plane.x >= 0.0f ? bounds.max_x[i] : bounds.min_x[i];
+            float y = plane.y >= 0.0f ? bounds.max_y[i] : bounds.min_y[i];
+            float z = plane.z >= 0.0f ? bounds.max_z[i] : bounds.min_z[i];
+            // Same summation order as the SIMD kernels so every path classifies boxes identically
+            float distance = plane.w + plane.x * x;
+            distance += plane.y * y;
+            distance += plane.z * z;
+            inside = distance >= 0.0f;
+        }
+        visible[i] = inside;
+    }
+}
+
+// The furthest corner along a plane depends only on the plane's signs, so the min or max array for each axis
+// is picked once per plane and the dot products of 4 (SSE) or 8 (AVX) boxes are evaluated together
+#ifdef __SSE2__
+void Frustum::test_sse(const BoundsArray& bounds, unsigned char* visible) const {
+    const float* xs[6];
+    const float* ys[6];
+    const float* zs[6];
+    for (int p = 0; p < 6; p += 1) {
+        xs[p] = this->planes[p].x >= 0.0f ? bounds.max_x.data() : bounds.min_x.data();
+        ys[p] = this->planes[p].y >= 0.0f ? bounds.max_y.data() : bounds.min_y.data();
+        zs[p] = this->planes[p].z >= 0.0f ? bounds.max_z.data() : bounds.min_z.data();
+    }
+
+    size_t count = bounds.size() / 4 * 4;
+    for (size_t i = 0; i < count; i += 4) {
+        __m128 outside = _mm_setzero_ps();
+        for (int p = 0; p < 6; p += 1) {
+            __m128 distance = _mm_set1_ps(this->planes[p].w);
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(this->planes[p].x), _mm_loadu_ps(xs[p] + i)));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(this->planes[p].y), _mm_loadu_ps(ys[p] + i)));
+            distance = _mm_add_ps(distance, _mm_mul_ps(_mm_set1_ps(this->planes[p].z), _mm_loadu_ps(zs[p] + i)));
+            outside = _mm_or_ps(outside, _mm_cmplt_ps(distance, _mm_setzero_ps()));
+        }
+
+        int mask = _mm_movemask_ps(outside);
+        for (int lane = 0; lane < 4; lane += 1) {
+            visible[i + lane] = !(mask & (1 << lane));
+        }
+    }
+
+    this->test_scalar(bounds, count, visible);
+}
+#endif
+
+#ifdef __AVX__
+void Frustum::test_avx(const BoundsArray& bounds, unsigned char* visible) const {
+    const float* xs[6];
+    const float* ys[6];
+    const float* zs[6];
+    for (int p = 0; p < 6; p += 1) {
+        xs[p] = this->planes[p].x >= 0.0f ? bounds.max_x.data() : bounds.min_x.data();
+        ys[p] = this->planes[p].y >= 0.0f ? bounds.max_y.data() : bounds.min_y.data();
+        zs[p] = this->planes[p].z >= 0.0f ? bounds.max_z.data() : bounds.min_z.data();
+    }
+
+    size_t count = bounds.size() / 8 * 8;
+    for (size_t i = 0; i < count; i += 8) {
+        __m256 outside = _mm256_setzero_ps();
+        for (int p = 0; p < 6; p += 1) {
+            __m256 distance = _mm256_set1_ps(this->planes[p].w);
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(this->planes[p].x), _mm256_loadu_ps(xs[p] + i)));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(this->planes[p].y), _mm256_loadu_ps(ys[p] + i)));
+            distance = _mm256_add_ps(distance, _mm256_mul_ps(_mm256_set1_ps(this->planes[p].z), _mm256_loadu_ps(zs[p] + i)));
+            outside = _mm256_or_ps(outside, _mm256_cmp_ps(distance, _mm256_setzero_ps(), _CMP_LT_OQ));
+        }
+
+        int mask = _mm256_movemask_ps(outside);
+        for (int lane = 0; lane < 8; lane += 1) {
+            visible[i + lane] = !(mask & (1 << lane));
+        }
+    }
+
+    this->test_scalar(bounds, count, visible);
+}
+#endif
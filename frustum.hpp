@@ -0,0 +1,42 @@
+#include <vector>
+#include "glm/glm/glm.hpp"
+
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+// Axis-aligned bounding box
+struct Bounds {
+    glm::vec3 min, max;
+};
+
+// Structure-of-arrays bounds, so a SIMD register holds the same coordinate of several boxes
+struct BoundsArray {
+    std::vector<float> min_x, min_y, min_z;
+    std::vector<float> max_x, max_y, max_z;
+
+    void push_back(const Bounds& bounds);
+    Bounds get(size_t i) const;
+    size_t size() const;
+    void clear();
+};
+
+// The six clip planes of a view-projection matrix, pointing inwards
+class Frustum {
+public:
+    Frustum(const glm::mat4& view_projection);
+    bool intersects(const Bounds& bounds) const;
+    // Batch tests write 1 to visible[i] when box i intersects the frustum and 0 otherwise.
+    // test() uses the widest kernel compiled in; the others are public for benchmarking.
+    void test(const BoundsArray& bounds, unsigned char* visible) const;
+    void test_scalar(const BoundsArray& bounds, size_t first, unsigned char* visible) const;
+#ifdef __SSE2__
+    void test_sse(const BoundsArray& bounds, unsigned char* visible) const;
+#endif
+#ifdef __AVX__
+    void test_avx(const BoundsArray& bounds, unsigned char* visible) const;
+#endif
+private:
+    glm::vec4 planes[6];
+};
+
+#endif
@@ -0,0 +1,141 @@
+#include <algorithm>
+
+#include "greedy.hpp"
+#include "trace.hpp"
+
+static bool same_color(const Color& a, const Color& b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+void greedy_mesh(const std::vector<Block>& blocks, const std::function<bool(int, int, int)>& occupied, std::vector<Quad>& quads) {
+    TRACE_ZONE("greedy_mesh");
+    if (blocks.empty()) {
+        return;
+    }
+
+    // Dense grid over the blocks' bounds holding the index of the block in each cell, or -1
+    int lo[3] = {blocks[0].x, blocks[0].y, blocks[0].z};
+    int hi[3] = {lo[0], lo[1], lo[2]};
+    for (const Block& block : blocks) {
+        int cell[3] = {block.x, block.y, block.z};
+        for (int axis = 0; axis < 3; axis += 1) {
+            lo[axis] = std::min(lo[axis], cell[axis]);
+            hi[axis] = std::max(hi[axis], cell[axis]);
+        }
+    }
+    int dims[3] = {hi[0] - lo[0] + 1, hi[1] - lo[1] + 1, hi[2] - lo[2] + 1};
+
+    auto index = [&](const int* p) {
+        return (p[0] - lo[0]) + dims[0] * ((p[1] - lo[1]) + dims[1] * (p[2] - lo[2]));
+    };
+    auto inside = [&](const int* p) {
+        return p[0] >= lo[0] && p[0] <= hi[0] && p[1] >= lo[1] && p[1] <= hi[1] && p[2] >= lo[2] && p[2] <= hi[2];
+    };
+
+    std::vector<int> cells(dims[0] * dims[1] * dims[2], -1);
+    for (size_t i = 0; i < blocks.size(); i += 1) {
+        int cell[3] = {blocks[i].x, blocks[i].y, blocks[i].z};
+        cells[index(cell)] = i;
+    }
+
+    // For each axis d, each side and each slice of cells along d: mark the faces that are exposed on that side,
+    // then grow every unvisited face along u into a run and the run along v while the whole row matches
+    std::vector<int> mask;
+    for (int d = 0; d < 3; d += 1) {
+        int u = (d + 1) % 3;
+        int v = (d + 2) % 3;
+        mask.resize(dims[u] * dims[v]);
+
+        for (int side = -1; side <= 1; side += 2) {
+            for (int slice = lo[d]; slice <= hi[d]; slice += 1) {
+                int p[3];
+                p[d] = slice;
+                for (int j = 0; j < dims[v]; j += 1) {
+                    for (int i = 0; i < dims[u]; i += 1) {
+                        p[u] = lo[u] + i;
+                        p[v] = lo[v] + j;
+                        int block = cells[index(p)];
+                        if (block >= 0) {
+                            int n[3] = {p[0], p[1], p[2]};
+                            n[d] += side;
+                            if (inside(n) ? cells[index(n)] >= 0 : occupied(n[0], n[1], n[2])) {
+                                block = -1;
+                            }
+                        }
+                        mask[i + j * dims[u]] = block;
+                    }
+                }
+
+                auto matches = [&](int entry, int block) {
+                    return entry >= 0 && same_color(blocks[entry].color, blocks[block].color);
+                };
+
+                for (int j = 0; j < dims[v]; j += 1) {
+                    for (int i = 0; i < dims[u]; ) {
+                        int block = mask[i + j * dims[u]];
+                        if (block < 0) {
+                            i += 1;
+                            continue;
+                        }
+
+                        int width = 1;
+                        while (i + width < dims[u] && matches(mask[i + width + j * dims[u]], block)) {
+                            width += 1;
+                        }
+                        int height = 1;
+                        for (; j + height < dims[v]; height += 1) {
+                            int k = 0;
+                            while (k < width && matches(mask[i + k + (j + height) * dims[u]], block)) {
+                                k += 1;
+                            }
+                            if (k < width) {
+                                break;
+                            }
+                        }
+
+                        // e_u x e_v = e_d, so the corners wind counter-clockwise around +d; swap two for -d
+                        glm::vec3 base(0.0f), du(0.0f), dv(0.0f);
+                        base[d] = slice + (side > 0 ? 1 : 0);
+                        base[u] = lo[u] + i;
+                        base[v] = lo[v] + j;
+                        du[u] = width;
+                        dv[v] = height;
+
+                        Quad quad;
+                        quad.corners[0] = base;
+                        quad.corners[1] = side > 0 ? base + du : base + dv;
+                        quad.corners[2] = side > 0 ? base + dv : base + du;
+                        quad.corners[3] = base + du + dv;
+                        quad.normal = glm::vec3(0.0f);
+                        quad.normal[d] = side;
+                        quad.color = blocks[block].color;
+                        quads.push_back(quad);
+
+                        for (int y = 0; y < height; y += 1) {
+                            std::fill(mask.begin() + i + (j + y) * dims[u], mask.begin() + i + width + (j + y) * dims[u], -1);
+                        }
+                        i += width;
+                    }
+                }
+            }
+        }
+    }
+}
+
+// The four corners, for drawing with write_quad_indices
+void write_quad(const Quad& quad, Vertex* out) {
+    for (int corner = 0; corner < 4; corner += 1) {
+        const glm::vec3& position = quad.corners[corner];
+        out[corner] = {position.x, position.y, position.z, quad.color.r, quad.color.g, quad.color.b, quad.normal.x, quad.normal.y, quad.normal.z};
+    }
+}
+
+// Both triangles expanded to 6 vertices, for glDrawArrays
+void write_quad_triangles(const Quad& quad, Vertex* out) {
+    Vertex corners[4];
+    write_quad(quad, corners);
+    const int order[] = {0, 1, 2, 1, 3, 2};
+    for (int i = 0; i < 6; i += 1) {
+        out[i] = corners[order[i]];
+    }
+}
@@ -0,0 +1,30 @@
+#include <vector>
+#include <functional>
+#include "glm/glm/glm.hpp"
+#include "vertex.hpp"
+#include "cube.hpp"
+
+#ifndef GREEDY_H
+#define GREEDY_H
+
+// A unit block filling grid cell [x, x + 1) x [y, y + 1) x [z, z + 1)
+struct Block {
+    int x, y, z;
+    Color color;
+};
+
+// A rectangle of coplanar same-colored block faces. The corners form triangles {0, 1, 2} and {1, 3, 2},
+// counter-clockwise seen from the side the normal points to.
+struct Quad {
+    glm::vec3 corners[4];
+    glm::vec3 normal;
+    Color color;
+};
+
+// Covers every exposed face of blocks with maximal same-colored rectangles, sweeping each slice row by row.
+// A face is hidden by another block in the list, or by any cell outside their bounds for which occupied is true.
+void greedy_mesh(const std::vector<Block>& blocks, const std::function<bool(int, int, int)>& occupied, std::vector<Quad>& quads);
+void write_quad(const Quad& quad, Vertex* out);
+void write_quad_triangles(const Quad& quad, Vertex* out);
+
+#endif
@@ -0,0 +1,169 @@
+#include <iostream>
+#include <cstring>
+#ifdef FRAGMENT_EGL
+    #include <EGL/egl.h>
+    #include <EGL/eglext.h>
+#endif
+
+#include "headless.hpp"
+
+bool HeadlessContext::create(int width, int height) {
+    if (this->create_egl()) {
+        this->backend = "EGL surfaceless";
+    } else if (this->create_glfw()) {
+        this->backend = "hidden GLFW window";
+    } else {
+        std::cout << "Failed to create an offscreen OpenGL context" << std::endl;
+        return false;
+    }
+
+    return this->create_framebuffer(width, height);
+}
+
+void HeadlessContext::destroy() {
+    if (this->framebuffer != 0) {
+        glDeleteFramebuffers(1, &this->framebuffer);
+        glDeleteRenderbuffers(1, &this->color_buffer);
+        glDeleteRenderbuffers(1, &this->depth_buffer);
+        this->framebuffer = 0;
+    }
+
+#ifdef FRAGMENT_EGL
+    if (this->display != nullptr) {
+        eglMakeCurrent((EGLDisplay)this->display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        eglDestroyContext((EGLDisplay)this->display, (EGLContext)this->context);
+        eglTerminate((EGLDisplay)this->display);
+        this->display = nullptr;
+    }
+#endif
+
+    if (this->window != nullptr) {
+        glfwTerminate();
+        this->window = nullptr;
+    }
+}
+
+const char* HeadlessContext::getBackend() {
+    return this->backend;
+}
+
+// Surfaceless needs EGL_MESA_platform_surfaceless (or a default display that supports
+// EGL_KHR_surfaceless_context); without either this returns false and GLFW is tried
+bool HeadlessContext::create_egl() {
+#ifdef FRAGMENT_EGL
+    EGLDisplay display = EGL_NO_DISPLAY;
+    const char* client_extensions = eglQueryString(EGL_NO_DISPLAY, EGL_EXTENSIONS);
+    if (client_extensions != nullptr && std::strstr(client_extensions, "EGL_MESA_platform_surfaceless")) {
+        auto get_platform_display = (PFNEGLGETPLATFORMDISPLAYEXTPROC)eglGetProcAddress("eglGetPlatformDisplayEXT");
+        if (get_platform_display != nullptr) {
+            display = get_platform_display(EGL_PLATFORM_SURFACELESS_MESA, EGL_DEFAULT_DISPLAY, nullptr);
+        }
+    }
+    if (display == EGL_NO_DISPLAY) {
+        display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    }
+
+    EGLint major, minor;
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, &major, &minor)) {
+        return false;
+    }
+
+    const char* extensions = eglQueryString(display, EGL_EXTENSIONS);
+    if (extensions == nullptr || !std::strstr(extensions, "EGL_KHR_surfaceless_context") || !eglBindAPI(EGL_OPENGL_API)) {
+        eglTerminate(display);
+        return false;
+    }
+
+    // Nothing is ever drawn to an EGL surface, so skip choosing a config where the display allows it
+    // (Mesa's surfaceless platform exposes no configs at all)
+    EGLConfig config = EGL_NO_CONFIG_KHR;
+    if (!std::strstr(extensions, "EGL_KHR_no_config_context")) {
+        EGLint config_attributes[] = {EGL_RENDERABLE_TYPE, EGL_OPENGL_BIT, EGL_NONE};
+        EGLint config_count = 0;
+        if (!eglChooseConfig(display, config_attributes, &config, 1, &config_count) || config_count == 0) {
+            eglTerminate(display);
+            return false;
+        }
+    }
+
+    // Same version and profile the windowed path asks GLFW for
+    EGLint context_attributes[] = {
+        EGL_CONTEXT_MAJOR_VERSION, 3,
+        EGL_CONTEXT_MINOR_VERSION, 3,
+        EGL_CONTEXT_OPENGL_PROFILE_MASK, EGL_CONTEXT_OPENGL_CORE_PROFILE_BIT,
+        EGL_NONE
+    };
+    EGLContext context = eglCreateContext(display, config, EGL_NO_CONTEXT, context_attributes);
+    if (context == EGL_NO_CONTEXT || !eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, context)) {
+        eglTerminate(display);
+        return false;
+    }
+
+    if (!gladLoadGLLoader((GLADloadproc)eglGetProcAddress)) {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        eglDestroyContext(display, context);
+        eglTerminate(display);
+        return false;
+    }
+
+    this->display = display;
+    this->context = context;
+    return true;
+#else
+    return false;
+#endif
+}
+
+bool HeadlessContext::create_glfw() {
+    if (glfwInit() == GLFW_FALSE) {
+        return false;
+    }
+
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    glfwWindowHint(GLFW_VISIBLE, GLFW_FALSE);
+#ifdef __APPLE__
+    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+#endif
+
+    // Rendering goes to the framebuffer, so the window itself can be tiny
+    this->window = glfwCreateWindow(1, 1, "Fragment", NULL, NULL);
+    if (!this->window) {
+        glfwTerminate();
+        return false;
+    }
+
+    glfwMakeContextCurrent(this->window);
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        glfwTerminate();
+        this->window = nullptr;
+        return false;
+    }
+
+    return true;
+}
+
+bool HeadlessContext::create_framebuffer(int width, int height) {
+    glGenRenderbuffers(1, &this->color_buffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, this->color_buffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+
+    glGenRenderbuffers(1, &this->depth_buffer);
+    glBindRenderbuffer(GL_RENDERBUFFER, this->depth_buffer);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH24_STENCIL8, width, height);
+
+    glGenFramebuffers(1, &this->framebuffer);
+    glBindFramebuffer(GL_FRAMEBUFFER, this->framebuffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, this->color_buffer);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_STENCIL_ATTACHMENT, GL_RENDERBUFFER, this->depth_buffer);
+
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        std::cout << "Offscreen framebuffer is incomplete" << std::endl;
+        return false;
+    }
+
+    glViewport(0, 0, width, height);
+    return true;
+}
@@ -0,0 +1,34 @@
+#ifdef __APPLE__
+    #include <OpenGL/gl3.h>
+#else
+    #include <OpenGL/gl.h>
+#endif
+// Include glad before GLFW per documentation
+#include "glad/glad.h"
+#include <GLFW/glfw3.h>
+
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+// Offscreen GL context rendering into its own framebuffer, for machines with no display.
+// Prefers an EGL surfaceless context (Mesa llvmpipe needs no GPU either) when built with FRAGMENT_EGL,
+// falling back to a hidden GLFW window. Either way glad is loaded and the framebuffer is bound on return.
+class HeadlessContext {
+public:
+    bool create(int width, int height);
+    void destroy();
+    const char* getBackend();
+private:
+    bool create_egl();
+    bool create_glfw();
+    bool create_framebuffer(int width, int height);
+    const char* backend = "none";
+    GLFWwindow* window = nullptr;
+    void* display = nullptr;
+    void* context = nullptr;
+    unsigned int framebuffer = 0;
+    unsigned int color_buffer = 0;
+    unsigned int depth_buffer = 0;
+};
+
+#endif
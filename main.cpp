@@ -3,6 +3,9 @@
 #include <random>
 #include <fstream>
 #include <string>
+#include <chrono>
+#include <cmath>
+#include <algorithm>
 #ifdef __APPLE__
     #include <OpenGL/gl3.h>
 #else
@@ -18,19 +21,18 @@
 #include "glm/glm/gtc/type_ptr.hpp"
 #include "shader.hpp"
 #include "vertex.hpp"
+#include "cube.hpp"
+#include "world.hpp"
+#include "mesh.hpp"
+#include "raycast.hpp"
+#include "buffer.hpp"
 #include "camera.hpp"
-
-struct CubeSize {
-    float x, y, z;
-};
-
-struct Origin {
-    float x, y, z;
-};
-
-struct Color {
-    float r, g, b;
-};
+#include "random.hpp"
+#include "options.hpp"
+#include "thread_pool.hpp"
+#include "headless.hpp"
+#include "profiler.hpp"
+#include "trace.hpp"
 
 enum KeyboardPress {
     SPACE
@@ -51,54 +53,9 @@ float lastFrame = 0.0f;
 
 Camera camera = Camera(glm::vec3(0.0f, 2.0f, 0.0f));
 
-std::vector<Vertex> create_cube(CubeSize size, Origin origin, Color color) {
-    std::vector<Vertex> vertices = {
-        // Front
-        { origin.x + size.x / 2,  origin.y + size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, 1.0f, },
-        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, 1.0f, },
-        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, 1.0f, },
-        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, 1.0f, },
-        { origin.x - size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, 1.0f, },
-        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, 1.0f, },
-        // Back
-        { origin.x + size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, -1.0f, },
-        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, -1.0f, },
-        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, -1.0f, },
-        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, -1.0f, },
-        { origin.x - size.x / 2,  origin.y - size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, -1.0f, },
-        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 0.0f, -1.0f, },
-        // Top
-        { origin.x + size.x / 2,  origin.y + size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 1.0f, 0.0f, },
-        { origin.x + size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 1.0f, 0.0f, },
-        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 1.0f, 0.0f, },
-        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, 1.0f, 0.0f, },
-        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 1.0f, 0.0f, },
-        { origin.x + size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, 1.0f, 0.0f, },
-        // Bottom
-        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, -1.0f, 0.0f, },
-        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, -1.0f, 0.0f, },
-        { origin.x - size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, -1.0f, 0.0f, },
-        { origin.x - size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 0.0f, -1.0f, 0.0f, },
-        { origin.x - size.x / 2,  origin.y - size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, -1.0f, 0.0f, },
-        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 0.0f, -1.0f, 0.0f, },
-        // Left
-        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, -1.0f, 0.0f, 0.0f, },
-        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, -1.0f, 0.0f, 0.0f, },
-        { origin.x - size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, -1.0f, 0.0f, 0.0f, },
-        { origin.x - size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, -1.0f, 0.0f, 0.0f, },
-        { origin.x - size.x / 2,  origin.y - size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, -1.0f, 0.0f, 0.0f, },
-        { origin.x - size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, -1.0f, 0.0f, 0.0f, },
-        // Right
-        { origin.x + size.x / 2,  origin.y + size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 1.0f,  0.0f, 0.0f, },
-        { origin.x + size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 1.0f,  0.0f, 0.0f, },
-        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 1.0f,  0.0f, 0.0f, },
-        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z + size.z / 2, color.r, color.g, color.b, 1.0f,  0.0f, 0.0f, },
-        { origin.x + size.x / 2,  origin.y - size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 1.0f,  0.0f, 0.0f, },
-        { origin.x + size.x / 2,  origin.y + size.y / 2, origin.z - size.z / 2, color.r, color.g, color.b, 1.0f,  0.0f, 0.0f, },
-    };
-
-    return vertices;
-}
+// The player's box around the camera: 0.6 wide, from the feet 1.7 below the eye to just above it
+const glm::vec3 PLAYER_LOW = glm::vec3(-0.3f, -1.7f, -0.3f);
+const glm::vec3 PLAYER_HIGH = glm::vec3(0.3f, 0.1f, 0.3f);
 
 void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
     if (firstMouse) {
@@ -117,25 +74,7 @@ void mouse_callback(GLFWwindow* window, double xpos, double ypos) {
 }
 
 float random_float(float min, float max) {
-    std::random_device rd;
-    std::mt19937 gen(rd());
-    std::uniform_real_distribution<> dis(min, max);
-    return (float)dis(gen);
-}
-
-std::vector<Vertex> create_random_cube() {
-    Origin origin = {random_float(-100.0f, 100.0f), random_float(0.0f, 0.0f), random_float(-100.0f, 100.0f)};
-    CubeSize size = {random_float(10.0f, 20.0f), random_float(10.0f, 100.0f), random_float(10.0f, 20.0f)};
-    Color color = {random_float(0.0, 1.0), random_float(0.0, 1.0), random_float(0.0, 1.0)};
-    auto cube = create_cube(size, origin, color);
-    return cube;
-}
-
-std::vector<Vertex> create_uniform_cube(Origin origin) {
-    CubeSize size = {random_float(1.0f, 1.0f), random_float(1.0f, 1.0f), random_float(1.0f, 1.0f)};
-    Color color = {random_float(0.0, 1.0), random_float(0.0, 1.0), random_float(0.0, 1.0)};
-    auto cube = create_cube(size, origin, color);
-    return cube;
+    return thread_random().next_float(min, max);
 }
 
 // char* string_to_mutable_char_array(std::string str) {
@@ -152,51 +91,205 @@ void framebuffer_size_callback(GLFWwindow* window, int width, int height) {
     glViewport(0, 0, width, height);
 }
 
-std::vector<Vertex> init_world() {
-    std::vector<Vertex> vertices = {};
+Options options;
+
+// Boxes live in spatial chunks, each with its own VAO
+World world;
+
+// Every building draws from its own keyed generator, so buildings come out the same on any thread in any order.
+// Its color, size and position come from one batch of unit floats, scaled the way next_float(min, max) would.
+Instance create_building(uint64_t seed, uint64_t index, float half) {
+    Random random = Random::keyed(seed, index);
+    float unit[6];
+    random.next_floats(unit, 6, 0.0f, 1.0f);
+    float colorElement = 0.5f + 0.25f * unit[0];
+    CubeSize size = {30.0f + 50.0f * unit[1], 10.0f + 90.0f * unit[2], 30.0f + 50.0f * unit[3]};
+    Origin origin = {-half + 2 * half * unit[4], size.y / 2, -half + 2 * half * unit[5]};
+    return {origin.x, origin.y, origin.z, size.x, size.y, size.z, colorElement, colorElement, colorElement};
+}
+
+// Deterministic for a given seed, building count and world size, whatever the thread count
+void init_world(ThreadPool& pool) {
+    TRACE_ZONE("init_world");
+    float half = options.world_size / 2;
+    uint64_t seed = random_seed();
 
     // Create ground plane/cube
-    CubeSize size = {1000, 0.1, 1000};
+    CubeSize size = {options.world_size, 0.1, options.world_size};
     Origin origin = {0.0, 0.0, 0.0};
     Color color = {127.0f / 255.0f, 0.98f, 0.0f};
-    auto ground = create_cube(size, origin, color);
-    vertices.insert(vertices.end(), ground.begin(), ground.end());
-
-    // Create buildings
-    for (int i = 0; i < 100; i += 1) {
-        float colorElement = random_float(0.5f, 0.75f);
-        color = {colorElement, colorElement, colorElement};
-        size = {random_float(30.0f, 80.0f), random_float(10.0f, 100.0f), random_float(30.0f, 80.0f)};
-        origin = {random_float(-500.0f, 500.0f), size.y / 2, random_float(-500.0f, 500.0f)};
-        auto building = create_cube(size, origin, color);
-        vertices.insert(vertices.end(), building.begin(), building.end());
-    }
+    world.add_box(size, origin, color);
+
+    // Create buildings, each thread filling its own slice of the pre-sized array
+    std::vector<Instance> buildings(options.buildings);
+    pool.parallel_for(buildings.size(), [&](size_t begin, size_t end) {
+        TRACE_ZONE("create_building range");
+        for (size_t i = begin; i < end; i += 1) {
+            buildings[i] = create_building(seed, i, half);
+        }
+    });
+    world.add_boxes(buildings, pool);
 
-    // Create golden cube
+    // Create golden cube, keyed after the last building
+    Random random = Random::keyed(seed, options.buildings);
     size = {10, 10, 10};
-    origin = {random_float(-500.0f, 500.0f), 0.0, random_float(-500.0f, 500.0f)};
+    origin = {random.next_float(-half, half), 0.0, random.next_float(-half, half)};
     color = {255.0f / 255.0f, 215.0f / 255.0f, 0.0f};
-    auto goldenCube = create_cube(size, origin, color);
-    vertices.insert(vertices.end(), goldenCube.begin(), goldenCube.end());
+    world.add_box(size, origin, color);
+}
+
+FrameProfiler profiler;
+
+// Create shaders. Chunk meshes are built in world space, so the world is drawn without a model transform.
+Shader shader = Shader("shaders/basic.vs", "shaders/basic.fs", "#define WORLD_SPACE\n");
 
-    return vertices;
+// Camera and light data shared by every program through the Frame uniform block
+UniformBuffer frame_uniforms = UniformBuffer(FRAME_UNIFORM_BINDING, sizeof(FrameUniforms));
+
+// The window size and field of view never change, so neither does the projection
+const glm::mat4 projection = glm::perspective(glm::radians(45.0f), (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT, 0.1f, 1000.0f);
+
+void report_culling() {
+    DrawStats stats = world.getDrawStats();
+    std::cout << "Culling: drew " << stats.drawn_boxes << " boxes in " << stats.drawn_chunks << " chunks with " << stats.draw_calls << " draw calls, "
+              << "culled " << stats.culled_boxes << " boxes (" << stats.culled_chunks << " whole chunks)" << std::endl;
+    if (options.occlusion && options.culling) {
+        size_t in_view = stats.drawn_boxes + stats.occluded_boxes;
+        std::cout << "Occlusion: " << stats.occluders << " occluders hid " << stats.occluded_boxes << " boxes (" << stats.occluded_chunks << " whole chunks), "
+                  << (in_view > 0 ? 100.0 * stats.occluded_boxes / in_view : 0.0) << "% of the draws left after frustum culling" << std::endl;
+    }
 }
 
-auto vertices = init_world();
+// Stress mode places this many random blocks per second and reports upload cost
+float stress_budget = 0.0f;
+unsigned int stress_blocks = 0;
+unsigned int stress_removed = 0;
+double stress_upload_seconds = 0.0;
+std::vector<glm::ivec3> stress_cells; // live stress blocks, for --churn
 
-// Create shaders
-Shader shader = Shader("shaders/basic.vs", "shaders/basic.fs");
+// The grid cell containing origin
+glm::ivec3 cell_at(Origin origin) {
+    return glm::ivec3((int)std::floor(origin.x), (int)std::floor(origin.y), (int)std::floor(origin.z));
+}
 
+// False if a block is already there
+bool place_block(glm::ivec3 cell) {
+    Color color = {random_float(0.0, 1.0), random_float(0.0, 1.0), random_float(0.0, 1.0)};
+    return world.add_block(cell.x, cell.y, cell.z, color);
+}
+
+// How far away blocks can be placed, removed and highlighted
+const float REACH = 100.0f;
+
+// What the center of the screen points at
+bool target(RayHit& hit) {
+    return world.raycast(camera.getPosition(), camera.Front, REACH, hit);
+}
+
+// Attaches a block to the face in front of the camera, whether of a block or a building
 void add_block() {
-    Origin origin = {camera.getPosition().x + camera.Front.x * 4, camera.getPosition().y + camera.Front.y * 4, camera.getPosition().z + camera.Front.z * 4};
-    auto cube = create_uniform_cube(origin);
-    vertices.insert(vertices.end(), cube.begin(), cube.end());
-    shader.bind_buffers(vertices);
+    TRACE_ZONE("add_block");
+    RayHit hit;
+    if (target(hit) && hit.normal != glm::ivec3(0)) {
+        place_block(hit.cell + hit.normal);
+    }
+}
+
+void remove_block() {
+    TRACE_ZONE("remove_block");
+    RayHit hit;
+    if (target(hit) && hit.block) {
+        world.remove_block(hit.cell.x, hit.cell.y, hit.cell.z);
+    }
+}
+
+// Crosshair and an outline of the unit face it points at, raycast and rebuilt every frame
+Mesh highlight;
+std::vector<Vertex> highlight_vertices;
+
+void add_line(glm::vec3 a, glm::vec3 b, glm::vec3 normal) {
+    highlight_vertices.push_back({a.x, a.y, a.z, 0.0f, 0.0f, 0.0f, normal.x, normal.y, normal.z});
+    highlight_vertices.push_back({b.x, b.y, b.z, 0.0f, 0.0f, 0.0f, normal.x, normal.y, normal.z});
+}
+
+void draw_highlight() {
+    TRACE_ZONE("draw_highlight");
+    highlight_vertices.clear();
+
+    RayHit hit;
+    if (target(hit) && hit.normal != glm::ivec3(0)) {
+        // The square lies on the hit face, lifted off it a little so it is not lost to depth fighting
+        glm::vec3 normal = glm::vec3(hit.normal);
+        int d = hit.normal.x != 0 ? 0 : (hit.normal.y != 0 ? 1 : 2);
+        glm::vec3 base = glm::vec3(hit.cell);
+        base[d] = hit.point[d];
+        base += normal * 0.01f;
+        glm::vec3 du(0.0f), dv(0.0f);
+        du[(d + 1) % 3] = 1.0f;
+        dv[(d + 2) % 3] = 1.0f;
+        add_line(base, base + du, normal);
+        add_line(base + du, base + du + dv, normal);
+        add_line(base + du + dv, base + dv, normal);
+        add_line(base + dv, base, normal);
+    }
+
+    // Drawn in the world one unit ahead of the camera, so the regular shader can place it
+    glm::vec3 center = camera.getPosition() + camera.Front;
+    glm::vec3 right = camera.Right * 0.015f;
+    glm::vec3 up = camera.Up * 0.015f;
+    add_line(center - right, center + right, -camera.Front);
+    add_line(center - up, center + up, -camera.Front);
+
+    highlight.bind_buffers(highlight_vertices);
+    glBindVertexArray(highlight.getVAO());
+    glDrawArrays(GL_LINES, 0, highlight_vertices.size());
+}
+
+void stress_blocks_for_frame() {
+    TRACE_ZONE("stress_blocks_for_frame");
+    stress_budget += options.stress_rate * deltaTime;
+
+    auto start = std::chrono::steady_clock::now();
+    while (stress_budget >= 1.0f) {
+        Origin origin = {camera.getPosition().x + random_float(-50.0f, 50.0f), random_float(0.5f, 20.0f), camera.getPosition().z + random_float(-100.0f, 0.0f)};
+        glm::ivec3 cell = cell_at(origin);
+        if (place_block(cell)) {
+            stress_blocks += 1;
+            stress_cells.push_back(cell);
+        }
+        stress_budget -= 1.0f;
+
+        // Swap-remove a random live block so the list stays dense
+        if (options.churn > 0 && stress_cells.size() > (size_t)options.churn) {
+            size_t victim = std::min((size_t)random_float(0.0f, (float)stress_cells.size()), stress_cells.size() - 1);
+            glm::ivec3 removed = stress_cells[victim];
+            stress_cells[victim] = stress_cells.back();
+            stress_cells.pop_back();
+            world.remove_block(removed.x, removed.y, removed.z);
+            stress_removed += 1;
+        }
+    }
+    world.upload();
+    stress_upload_seconds += std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report_stress(float seconds) {
+    StreamBuffer& stream = world.getStreamBuffer();
+    std::cout << "Stress: " << stress_blocks << " blocks placed, " << stress_removed << " removed in " << seconds << "s, "
+              << stress_upload_seconds * 1000.0 << "ms placing/uploading, "
+              << stream.getStalls() << " ring stalls (" << stream.getStallSeconds() * 1000.0 << "ms"
+              << (stream.isPersistent() ? ", persistent map" : "") << ")" << std::endl;
+    const VoxelStore& voxels = world.getVoxels();
+    std::cout << "Stress: " << voxels.getCount() << " blocks stored in " << voxels.getBrickCount() << " bricks ("
+              << voxels.getBytes() / 1024 << " KiB), " << world.getFaceCount() << " faces in the world, "
+              << world.getBlockMeshBytes() / 1024 << " KiB of block meshes on the GPU" << std::endl;
 }
 
 bool SPACE_DOWN = false;
+bool X_DOWN = false;
 
 void process_input(GLFWwindow* window) {
+    TRACE_ZONE("process_input");
     // std::cout << camera.getPosition().x << " " << camera.getPosition().z << std::endl;
     if (glfwGetKey(window, GLFW_KEY_ESCAPE) == GLFW_PRESS) {
         glfwSetWindowShouldClose(window, true);
@@ -213,6 +306,9 @@ void process_input(GLFWwindow* window) {
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS) {
         camera.processKeyboard(RIGHT, deltaTime);
     }
+    // Walls stop the player and the rest of the move slides along them
+    Bounds body = {camera.Position + PLAYER_LOW, camera.Position + PLAYER_HIGH};
+    camera.Position += world.move(body, camera.takeMovement());
     if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS) {
         SPACE_DOWN = true;
     }
@@ -222,51 +318,186 @@ void process_input(GLFWwindow* window) {
             SPACE_DOWN = false;
         }
     }
+    if (glfwGetKey(window, GLFW_KEY_X) == GLFW_PRESS) {
+        X_DOWN = true;
+    }
+    if (glfwGetKey(window, GLFW_KEY_X) == GLFW_RELEASE) {
+        if (X_DOWN) {
+            remove_block();
+            X_DOWN = false;
+        }
+    }
 }
 
-int main(int argc, char* argv[]) {
+// Uniforms, clear and world draw for the current camera; the caller presents or finishes the frame
+void render_frame() {
+    TRACE_ZONE("render_frame");
+    // Per-frame data goes up in one block
+    glUseProgram(shader.getProgram());
+
+    FrameUniforms frame;
+    frame.view = camera.getViewMatrix();
+    frame.projection = projection;
+    frame.view_projection = projection * frame.view;
+    frame.camera_position = glm::vec4(camera.getPosition(), 1.0f);
+    frame.light_position = glm::vec4(10.0f, 100.0f, 10.0f, 1.0f);
+    frame.light_params = glm::vec4(0.25f, 0.5f, 32.0f, 0.0f);
+    frame_uniforms.update(&frame);
+    profiler.mark(STAGE_UNIFORMS);
+
+    // Set the background color
+    profiler.begin_gpu();
+    glClearColor(background_color.r, background_color.g, background_color.b, 1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    world.upload();
+    world.draw(Frustum(frame.view_projection), frame.view_projection, camera.getPosition());
+    // Headless runs keep to the world alone so their frames stay comparable
+    if (!options.headless) {
+        draw_highlight();
+    }
+    world.end_frame();
+    profiler.end_gpu();
+    profiler.mark(STAGE_DRAW);
+}
+
+void end_profiled_frame() {
+    DrawStats stats = world.getDrawStats();
+    profiler.end_frame(stats.draw_calls, stats.drawn_vertices);
+}
+
+void report_profile() {
+    if (!profiler.isEnabled()) {
+        return;
+    }
+
+    profiler.finish();
+    profiler.report();
+    if (!options.profile_csv.empty() && profiler.write_csv(options.profile_csv)) {
+        std::cout << "Wrote frame timings to " << options.profile_csv << std::endl;
+    }
+}
+
+// One loop around the world at street level over the whole run, facing along the path
+void follow_camera_path(int frame, int frames) {
+    float angle = 2.0f * glm::pi<float>() * frame / frames;
+    float radius = options.world_size / 4;
+    glm::vec3 position = glm::vec3(radius * std::cos(angle), 2.0f, radius * std::sin(angle));
+    camera.setPose(position, glm::degrees(angle) + 90.0f, 0.0f);
+}
+
+// Fixed 60 Hz steps, so every run renders exactly the same frames. Each frame is timed through glFinish.
+int run_headless() {
+    deltaTime = 1.0f / 60.0f;
+    std::vector<double> frame_seconds;
+    auto start = std::chrono::steady_clock::now();
+
+    for (int frame = 0; frame < options.frames; frame += 1) {
+        auto frame_start = std::chrono::steady_clock::now();
+        profiler.begin_frame();
+        follow_camera_path(frame, options.frames);
+        profiler.mark(STAGE_INPUT);
+        if (options.stress_rate > 0.0f) {
+            stress_blocks_for_frame();
+        }
+        profiler.mark(STAGE_UPDATE);
+        render_frame();
+        {
+            TRACE_ZONE("glFinish");
+            glFinish();
+        }
+        profiler.mark(STAGE_PRESENT);
+        end_profiled_frame();
+        frame_seconds.push_back(std::chrono::duration<double>(std::chrono::steady_clock::now() - frame_start).count());
+    }
+
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double fastest = *std::min_element(frame_seconds.begin(), frame_seconds.end());
+    double slowest = *std::max_element(frame_seconds.begin(), frame_seconds.end());
+    std::cout << "Headless: " << options.frames << " frames in " << seconds << "s, " << options.frames / seconds << " fps, "
+              << "frame ms avg " << seconds * 1000.0 / options.frames << " min " << fastest * 1000.0 << " max " << slowest * 1000.0 << std::endl;
+
+    if (options.cull_stats) {
+        report_culling();
+    }
+    if (options.stress_rate > 0.0f) {
+        report_stress(seconds);
+    }
+    report_profile();
+    if (!options.trace_path.empty()) {
+        write_trace(options.trace_path);
+    }
+
+    GLenum error = glGetError();
+    if (error != GL_NO_ERROR) {
+        std::cout << "OpenGL error 0x" << std::hex << error << std::dec << std::endl;
+        return -1;
+    }
+    return 0;
+}
 
-    if (glfwInit() == GLFW_FALSE) {
-        std::cout << "GLFW failed to initialize" << std::endl;
+int main(int argc, char* argv[]) {
+    if (!parse_options(argc, argv, options)) {
         return -1;
     }
-    std::cout << "GLFW Initialized!" << std::endl;
 
-    // Set the version and use the core profile
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
-    glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
-    glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
+    world.set_geometry_mode(options.geometry_mode);
+    world.set_streaming(options.streaming);
+    world.set_culling(options.culling);
+    world.set_packed_vertices(options.packed_vertices);
+    profiler.set_enabled(options.profile);
+
+    HeadlessContext headless;
+    GLFWwindow* window = nullptr;
+    if (options.headless) {
+        if (!headless.create(WINDOW_WIDTH, WINDOW_HEIGHT)) {
+            headless.destroy();
+            return -1;
+        }
+        std::cout << "Rendering offscreen through " << headless.getBackend() << std::endl;
+    } else {
+        if (glfwInit() == GLFW_FALSE) {
+            std::cout << "GLFW failed to initialize" << std::endl;
+            return -1;
+        }
+        std::cout << "GLFW Initialized!" << std::endl;
+
+        // Set the version and use the core profile
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MAJOR, 3);
+        glfwWindowHint(GLFW_CONTEXT_VERSION_MINOR, 3);
+        glfwWindowHint(GLFW_OPENGL_PROFILE, GLFW_OPENGL_CORE_PROFILE);
 
 #ifdef __APPLE__
-    glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
+        glfwWindowHint(GLFW_OPENGL_FORWARD_COMPAT, GL_TRUE);
 #endif
 
-    // Create the window
-    auto window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Fragment", NULL, NULL);
-    if (!window) {
-        std::cout << "GLFW failed to create a window. Terminating" << std::endl;
-        glfwTerminate();
-        return -1;
-    }
+        // Create the window
+        window = glfwCreateWindow(WINDOW_WIDTH, WINDOW_HEIGHT, "Fragment", NULL, NULL);
+        if (!window) {
+            std::cout << "GLFW failed to create a window. Terminating" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
 
-    // tell GLFW to capture our mouse
-    glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
+        // tell GLFW to capture our mouse
+        glfwSetInputMode(window, GLFW_CURSOR, GLFW_CURSOR_DISABLED);
 
-    // Set callbacks
-    glfwSetErrorCallback(error_callback);
-    glfwSetCursorPosCallback(window, mouse_callback);
-    glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
-    
-    glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+        // Set callbacks
+        glfwSetErrorCallback(error_callback);
+        glfwSetCursorPosCallback(window, mouse_callback);
+        glfwSetFramebufferSizeCallback(window, framebuffer_size_callback);
 
-    // Set window as the current context in the main thread
-    glfwMakeContextCurrent(window);
+        // Set window as the current context in the main thread
+        glfwMakeContextCurrent(window);
 
-    // Initialize GLAD
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        glfwTerminate();
-        return -1;
+        // Initialize GLAD
+        if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress)) {
+            std::cout << "Failed to initialize GLAD" << std::endl;
+            glfwTerminate();
+            return -1;
+        }
+
+        // GL calls are only valid once GLAD has loaded them for a current context
+        glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
     }
 
     // Compile shaders and link buffers
@@ -275,47 +506,82 @@ int main(int argc, char* argv[]) {
         return -1;
     }
 
-    shader.bind_buffers(vertices);
+    // Fresh world every run unless --seed is given; the seed is printed so any world can be regenerated
+    if (options.has_seed) {
+        seed_random(options.seed);
+    } else {
+        std::random_device rd;
+        seed_random(((uint64_t)rd() << 32) | rd());
+    }
+
+    ThreadPool pool(options.threads);
+    if (options.occlusion) {
+        world.set_occlusion(&pool);
+    }
+    auto generate_start = std::chrono::steady_clock::now();
+    init_world(pool);
+    double generate_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - generate_start).count();
+    std::cout << "World seed: " << random_seed() << ", checksum: " << std::hex << world.getChecksum() << std::dec << std::endl;
+    std::cout << "Generated in " << generate_seconds * 1000.0 << " ms on " << pool.getThreadCount() << " threads" << std::endl;
+    world.upload();
+    std::cout << world.getBoxCount() << " boxes in " << world.getChunkCount() << " chunks: " << world.getVertexCount() << " vertices ("
+              << world.getVertexBytes() / 1024 << " KiB), " << world.getIndexCount() << " indices" << std::endl;
 
     glEnable(GL_DEPTH_TEST);
     glEnable(GL_DEBUG_OUTPUT);
 
     camera.setMovementSpeed(40.0);
 
+    if (options.headless) {
+        int result = run_headless();
+        headless.destroy();
+        return result;
+    }
+
+    float stress_start = glfwGetTime();
+    float stress_report = stress_start;
+    float cull_report = stress_start;
+
     // Render loop   
     while(!glfwWindowShouldClose(window)) {
         float currentFrame = glfwGetTime();
         deltaTime = currentFrame - lastFrame;
         lastFrame = currentFrame;
 
+        profiler.begin_frame();
         process_input(window);
+        profiler.mark(STAGE_INPUT);
+
+        if (options.stress_rate > 0.0f) {
+            stress_blocks_for_frame();
+            if (currentFrame - stress_report >= 1.0f) {
+                report_stress(currentFrame - stress_start);
+                stress_report = currentFrame;
+            }
+        }
 
-        // Model matrix
-        glm::mat4 trans = glm::mat4(1.0f);
-        glUniformMatrix4fv(glGetUniformLocation(shader.getProgram(), "model"), 1, GL_FALSE, glm::value_ptr(trans));
-        
-        // Projection matrix
-        glm::mat4 projection = glm::mat4(1.0f);
-        projection = glm::perspective(glm::radians(45.0f), (float)WINDOW_WIDTH / (float)WINDOW_HEIGHT, 0.1f, 1000.0f);
-        glUniformMatrix4fv(glGetUniformLocation(shader.getProgram(), "projection"), 1, GL_FALSE, glm::value_ptr(projection));
-
-        // View matrix
-        glm::mat4 view = camera.getViewMatrix();
-        glUniformMatrix4fv(glGetUniformLocation(shader.getProgram(), "view"), 1, GL_FALSE, glm::value_ptr(view));
-
-        // Set camera_position for specular highlights
-        auto camera_position = camera.getPosition();
-        glUniform3fv(glGetUniformLocation(shader.getProgram(), "camera_position"), 1, &camera_position[0]);
-
-        // Set the background color
-        glClearColor(background_color.r, background_color.g, background_color.b, 1.0f);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        glUseProgram(shader.getProgram());
-        glBindVertexArray(shader.getVAO());
-        glDrawArrays(GL_TRIANGLES, 0, vertices.size());
-        // glDrawElements(GL_TRIANGLES, vertices.size(), GL_UNSIGNED_INT, 0);
-        glfwSwapBuffers(window);
+        profiler.mark(STAGE_UPDATE);
+        render_frame();
+
+        if (options.cull_stats && currentFrame - cull_report >= 1.0f) {
+            report_culling();
+            cull_report = currentFrame;
+        }
+        {
+            TRACE_ZONE("glfwSwapBuffers");
+            glfwSwapBuffers(window);
+        }
         glfwPollEvents();
+        profiler.mark(STAGE_PRESENT);
+        end_profiled_frame();
+    }
+
+    if (options.stress_rate > 0.0f) {
+        report_stress(glfwGetTime() - stress_start);
+    }
+    report_profile();
+    if (!options.trace_path.empty()) {
+        write_trace(options.trace_path);
     }
 
     glfwTerminate();
@@ -0,0 +1,138 @@
+#ifdef __APPLE__
+    #include <OpenGL/gl3.h>
+#else
+    #include <OpenGL/gl.h>
+#endif
+
+#include "mesh.hpp"
+#include "trace.hpp"
+
+void Mesh::create_vertex_array(unsigned int vertexBuffer, unsigned int indexBuffer, bool packed) {
+    unsigned int VAO;
+    glGenVertexArrays(1, &VAO);
+    // bind the Vertex Array Object first, then bind and set vertex buffer(s), and then configure vertex attributes(s).
+    glBindVertexArray(VAO);
+    this->VAO = VAO;
+
+    glBindBuffer(GL_ARRAY_BUFFER, vertexBuffer);
+
+    if (packed) {
+        // Integer steps converted as-is, color and normal normalized to [0, 1] and [-1, 1]
+        glVertexAttribPointer(0, 3, GL_SHORT, GL_FALSE, sizeof(PackedVertex), (void*)0);
+        glVertexAttribPointer(1, 4, GL_UNSIGNED_BYTE, GL_TRUE, sizeof(PackedVertex), (void*)(4 * sizeof(int16_t)));
+        glVertexAttribPointer(2, 4, GL_INT_2_10_10_10_REV, GL_TRUE, sizeof(PackedVertex), (void*)(4 * sizeof(int16_t) + 4));
+    } else {
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
+        glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(3 * sizeof(float)));
+        glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(6 * sizeof(float)));
+    }
+    glEnableVertexAttribArray(0);
+    glEnableVertexAttribArray(1);
+    glEnableVertexAttribArray(2);
+
+    // Instance attributes stay disabled for world-space geometry, so give them an identity transform and white tint
+    glVertexAttrib3f(3, 0.0f, 0.0f, 0.0f);
+    glVertexAttrib3f(4, 1.0f, 1.0f, 1.0f);
+    glVertexAttrib3f(5, 1.0f, 1.0f, 1.0f);
+
+    // note that this is allowed, the call to glVertexAttribPointer registered VBO as the vertex attribute's bound vertex buffer object so afterwards we can safely unbind
+    glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+    // remember: do NOT unbind the EBO while a VAO is active as the bound element buffer object IS stored in the VAO; keep the EBO bound.
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBuffer);
+
+    // You can unbind the VAO afterwards so other VAO calls won't accidentally modify this VAO, but this rarely happens. Modifying other
+    // VAOs requires a call to glBindVertexArray anyways so we generally don't unbind VAOs (nor VBOs) when it's not directly necessary.
+    glBindVertexArray(0);
+}
+
+void Mesh::bind_buffers(const std::vector<Vertex>& vertices) {
+    TRACE_ZONE("Mesh::bind_buffers");
+    if (this->VAO == 0) {
+        this->create_vertex_array(this->vertexBuffer.getBuffer(), this->indexBuffer.getBuffer());
+    }
+
+    this->vertexBuffer.assign(vertices.data(), sizeof(Vertex) * vertices.size());
+}
+
+void Mesh::bind_buffers(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices) {
+    TRACE_ZONE("Mesh::bind_buffers");
+    this->bind_buffers(vertices);
+    this->indexBuffer.assign(indices.data(), sizeof(unsigned int) * indices.size());
+}
+
+void Mesh::bind_buffers(const std::vector<PackedVertex>& vertices, const std::vector<unsigned int>& indices) {
+    TRACE_ZONE("Mesh::bind_buffers");
+    if (this->VAO == 0) {
+        this->create_vertex_array(this->vertexBuffer.getBuffer(), this->indexBuffer.getBuffer(), true);
+    }
+
+    this->vertexBuffer.assign(vertices.data(), sizeof(PackedVertex) * vertices.size());
+    this->indexBuffer.assign(indices.data(), sizeof(unsigned int) * indices.size());
+}
+
+// Draws shape's vertices and indices once per instance; the shape's buffers are shared, not copied
+void Mesh::bind_instanced_buffers(Mesh& shape, const std::vector<Instance>& instances) {
+    TRACE_ZONE("Mesh::bind_instanced_buffers");
+    if (this->VAO == 0) {
+        this->create_vertex_array(shape.vertexBuffer.getBuffer(), shape.indexBuffer.getBuffer());
+
+        glBindVertexArray(this->VAO);
+        glBindBuffer(GL_ARRAY_BUFFER, this->instanceBuffer.getBuffer());
+
+        // Origin, size and color advance once per instance instead of once per vertex
+        glVertexAttribPointer(3, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)0);
+        glEnableVertexAttribArray(3);
+        glVertexAttribDivisor(3, 1);
+
+        glVertexAttribPointer(4, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(3 * sizeof(float)));
+        glEnableVertexAttribArray(4);
+        glVertexAttribDivisor(4, 1);
+
+        glVertexAttribPointer(5, 3, GL_FLOAT, GL_FALSE, sizeof(Instance), (void*)(6 * sizeof(float)));
+        glEnableVertexAttribArray(5);
+        glVertexAttribDivisor(5, 1);
+
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+        glBindVertexArray(0);
+    }
+
+    this->instanceBuffer.assign(instances.data(), sizeof(Instance) * instances.size());
+}
+
+// Appends upload only the new records; the buffers double their capacity when they run out of room
+void Mesh::append_vertices(const Vertex* vertices, size_t count, StreamBuffer* stream) {
+    this->append(this->vertexBuffer, vertices, sizeof(Vertex) * count, stream);
+}
+
+void Mesh::append_vertices(const PackedVertex* vertices, size_t count, StreamBuffer* stream) {
+    this->append(this->vertexBuffer, vertices, sizeof(PackedVertex) * count, stream);
+}
+
+void Mesh::append_indices(const unsigned int* indices, size_t count, StreamBuffer* stream) {
+    this->append(this->indexBuffer, indices, sizeof(unsigned int) * count, stream);
+}
+
+void Mesh::append_instances(const Instance* instances, size_t count, StreamBuffer* stream) {
+    this->append(this->instanceBuffer, instances, sizeof(Instance) * count, stream);
+}
+
+// With a stream, appends are staged in the ring and copied GPU-side so the CPU never waits on a buffer in use
+void Mesh::append(GrowableBuffer& buffer, const void* data, size_t size, StreamBuffer* stream) {
+    TRACE_ZONE("Mesh::append");
+    if (stream != nullptr && size > 0 && size <= stream->getSectionSize()) {
+        size_t offset = stream->write(data, size);
+        buffer.append_copy(stream->getBuffer(), offset, size);
+    } else {
+        buffer.append(data, size);
+    }
+}
+
+unsigned int Mesh::getVAO() {
+    return this->VAO;
+}
+
+// GPU bytes allocated for this mesh's own buffers
+size_t Mesh::getCapacity() {
+    return this->vertexBuffer.getCapacity() + this->indexBuffer.getCapacity() + this->instanceBuffer.getCapacity();
+}
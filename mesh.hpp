@@ -0,0 +1,30 @@
+#include <vector>
+#include "vertex.hpp"
+#include "buffer.hpp"
+
+#ifndef MESH_H
+#define MESH_H
+
+// A VAO together with the growable buffers feeding it. The VAO is created on first bind and refilled afterwards.
+class Mesh {
+public:
+    void bind_buffers(const std::vector<Vertex>& vertices);
+    void bind_buffers(const std::vector<Vertex>& vertices, const std::vector<unsigned int>& indices);
+    void bind_buffers(const std::vector<PackedVertex>& vertices, const std::vector<unsigned int>& indices);
+    void bind_instanced_buffers(Mesh& shape, const std::vector<Instance>& instances);
+    void append_vertices(const Vertex* vertices, size_t count, StreamBuffer* stream = nullptr);
+    void append_vertices(const PackedVertex* vertices, size_t count, StreamBuffer* stream = nullptr);
+    void append_indices(const unsigned int* indices, size_t count, StreamBuffer* stream = nullptr);
+    void append_instances(const Instance* instances, size_t count, StreamBuffer* stream = nullptr);
+    unsigned int getVAO();
+    size_t getCapacity();
+private:
+    void create_vertex_array(unsigned int vertexBuffer, unsigned int indexBuffer, bool packed = false);
+    void append(GrowableBuffer& buffer, const void* data, size_t size, StreamBuffer* stream);
+    unsigned int VAO = 0;
+    GrowableBuffer vertexBuffer;
+    GrowableBuffer indexBuffer;
+    GrowableBuffer instanceBuffer;
+};
+
+#endif
@@ -0,0 +1,249 @@
+#ifdef __SSE2__
+    #include <immintrin.h>
+#endif
+#include <cmath>
+#include <algorithm>
+
+#include "occlusion.hpp"
+#include "trace.hpp"
+
+OcclusionBuffer::OcclusionBuffer() {
+    this->depth.resize(OCCLUSION_WIDTH * OCCLUSION_HEIGHT, 1.0f);
+    for (int level = 1; level < OCCLUSION_LEVELS; level += 1) {
+        this->min_depth[level].resize((OCCLUSION_WIDTH >> level) * (OCCLUSION_HEIGHT >> level), 1.0f);
+        this->max_depth[level].resize((OCCLUSION_WIDTH >> level) * (OCCLUSION_HEIGHT >> level), 1.0f);
+    }
+}
+
+// Triangles are set up once, then each band of rows is cleared, rasterized and reduced on its own thread
+void OcclusionBuffer::render(const glm::mat4& view_projection, const glm::vec3& eye, const std::vector<Bounds>& occluders, ThreadPool& pool) {
+    TRACE_ZONE("OcclusionBuffer::render");
+    this->view_projection = view_projection;
+    this->triangles.clear();
+    for (const Bounds& bounds : occluders) {
+        this->add_occluder(bounds, eye);
+    }
+
+    pool.parallel_for(OCCLUSION_HEIGHT / OCCLUSION_BAND, [&](size_t begin, size_t end) {
+        for (size_t band = begin; band < end; band += 1) {
+            std::fill(this->depth.begin() + band * OCCLUSION_BAND * OCCLUSION_WIDTH, this->depth.begin() + (band + 1) * OCCLUSION_BAND * OCCLUSION_WIDTH, 1.0f);
+            for (const OcclusionTriangle& triangle : this->triangles) {
+                this->rasterize(triangle, band);
+            }
+            this->build_levels(band);
+        }
+    });
+}
+
+// The faces of the box that look towards the eye, two counterclockwise triangles each. A box reaching in front of
+// the near plane, or with a corner too close to the eye's plane to project, is left out rather than clipped; it only
+// costs some occlusion.
+void OcclusionBuffer::add_occluder(const Bounds& bounds, const glm::vec3& eye) {
+    glm::vec3 corners[8];
+    for (int i = 0; i < 8; i += 1) {
+        glm::vec4 clip = this->view_projection * glm::vec4(i & 1 ? bounds.max.x : bounds.min.x, i & 2 ? bounds.max.y : bounds.min.y, i & 4 ? bounds.max.z : bounds.min.z, 1.0f);
+        if (clip.w < OCCLUSION_MIN_W || clip.z < -clip.w) {
+            return;
+        }
+        corners[i] = glm::vec3((clip.x / clip.w * 0.5f + 0.5f) * OCCLUSION_WIDTH, (clip.y / clip.w * 0.5f + 0.5f) * OCCLUSION_HEIGHT, clip.z / clip.w);
+    }
+
+    for (int axis = 0; axis < 3; axis += 1) {
+        for (int side = 0; side < 2; side += 1) {
+            if (side == 0 ? eye[axis] >= bounds.min[axis] : eye[axis] <= bounds.max[axis]) {
+                continue;
+            }
+
+            // Corners of the face in order around it
+            int u = (axis + 1) % 3;
+            int v = (axis + 2) % 3;
+            int quad[4];
+            int steps[4][2] = {{0, 0}, {1, 0}, {1, 1}, {0, 1}};
+            for (int i = 0; i < 4; i += 1) {
+                quad[i] = (side << axis) | (steps[i][0] << u) | (steps[i][1] << v);
+            }
+
+            for (int half = 0; half < 2; half += 1) {
+                OcclusionTriangle triangle = {corners[quad[0]], corners[quad[1 + half]], corners[quad[2 + half]]};
+                float area = (triangle.b.x - triangle.a.x) * (triangle.c.y - triangle.a.y) - (triangle.b.y - triangle.a.y) * (triangle.c.x - triangle.a.x);
+                if (area < 0.0f) {
+                    std::swap(triangle.b, triangle.c);
+                }
+                if (area != 0.0f) {
+                    this->triangles.push_back(triangle);
+                }
+            }
+        }
+    }
+}
+
+// Edge functions positive inside the counterclockwise triangle, evaluated at pixel centers four pixels at a time.
+// Depth is the triangle's plane at the pixel center pushed back to the farthest it gets within the pixel, and never
+// nearer than the nearest corner: rounding in the plane of a triangle far larger than the screen can otherwise put
+// it in front of the box it came from.
+void OcclusionBuffer::rasterize(const OcclusionTriangle& triangle, int band) {
+    const glm::vec3& a = triangle.a;
+    const glm::vec3& b = triangle.b;
+    const glm::vec3& c = triangle.c;
+    int x0 = std::max(0, (int)std::ceil(std::min(a.x, std::min(b.x, c.x)) - 0.5f));
+    int x1 = std::min(OCCLUSION_WIDTH - 1, (int)std::floor(std::max(a.x, std::max(b.x, c.x)) - 0.5f));
+    int y0 = std::max(band * OCCLUSION_BAND, (int)std::ceil(std::min(a.y, std::min(b.y, c.y)) - 0.5f));
+    int y1 = std::min(band * OCCLUSION_BAND + OCCLUSION_BAND - 1, (int)std::floor(std::max(a.y, std::max(b.y, c.y)) - 0.5f));
+    if (x0 > x1 || y0 > y1) {
+        return;
+    }
+
+    // Edge i is opposite vertex i and its function is that vertex's barycentric weight times the area
+    const glm::vec3* from[3] = {&b, &c, &a};
+    const glm::vec3* to[3] = {&c, &a, &b};
+    float edge_x[3], edge_y[3], edge_c[3];
+    for (int i = 0; i < 3; i += 1) {
+        edge_x[i] = from[i]->y - to[i]->y;
+        edge_y[i] = to[i]->x - from[i]->x;
+        edge_c[i] = from[i]->x * to[i]->y - from[i]->y * to[i]->x;
+    }
+    float area = edge_c[0] + edge_c[1] + edge_c[2];
+    float depth_x = (edge_x[0] * a.z + edge_x[1] * b.z + edge_x[2] * c.z) / area;
+    float depth_y = (edge_y[0] * a.z + edge_y[1] * b.z + edge_y[2] * c.z) / area;
+    float depth_c = (edge_c[0] * a.z + edge_c[1] * b.z + edge_c[2] * c.z) / area + 0.5f * (std::fabs(depth_x) + std::fabs(depth_y));
+    float depth_min = std::min(a.z, std::min(b.z, c.z));
+
+    for (int y = y0; y <= y1; y += 1) {
+        float center_y = y + 0.5f;
+        float* row = &this->depth[y * OCCLUSION_WIDTH];
+        float row_edge[3];
+        for (int i = 0; i < 3; i += 1) {
+            row_edge[i] = edge_y[i] * center_y + edge_c[i];
+        }
+        float row_depth = depth_y * center_y + depth_c;
+
+        // Where the row crosses each edge narrows the span to walk, give or take a pixel the edge tests settle. An
+        // almost horizontal edge crosses far off the row, or at infinity, so the crossing is clamped to just past
+        // either end of it before it is converted.
+        int span_begin = x0;
+        int span_end = x1;
+        for (int i = 0; i < 3; i += 1) {
+            if (edge_x[i] == 0.0f) {
+                span_end = row_edge[i] < 0.0f ? -1 : span_end;
+                continue;
+            }
+            float crossing = std::min(std::max(-row_edge[i] / edge_x[i] - 0.5f, -1.0f), (float)OCCLUSION_WIDTH);
+            if (edge_x[i] > 0.0f) {
+                span_begin = std::max(span_begin, (int)std::ceil(crossing) - 1);
+            } else {
+                span_end = std::min(span_end, (int)std::floor(crossing) + 1);
+            }
+        }
+
+        // Groups of four start on a multiple of four, which the row width is, so no group leaves the row
+        int x = span_begin & ~3;
+#ifdef __SSE2__
+        const __m128 offsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+        for (; x <= span_end; x += 4) {
+            __m128 center_x = _mm_add_ps(_mm_set1_ps((float)x), offsets);
+            __m128 inside = _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(edge_x[0]), center_x), _mm_set1_ps(row_edge[0])), _mm_setzero_ps());
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(edge_x[1]), center_x), _mm_set1_ps(row_edge[1])), _mm_setzero_ps()));
+            inside = _mm_and_ps(inside, _mm_cmpge_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(edge_x[2]), center_x), _mm_set1_ps(row_edge[2])), _mm_setzero_ps()));
+            __m128 depth = _mm_max_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(depth_x), center_x), _mm_set1_ps(row_depth)), _mm_set1_ps(depth_min));
+            __m128 old = _mm_loadu_ps(row + x);
+            _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, _mm_min_ps(old, depth)), _mm_andnot_ps(inside, old)));
+        }
+#else
+        for (; x <= span_end; x += 1) {
+            float center_x = x + 0.5f;
+            if (edge_x[0] * center_x + row_edge[0] >= 0.0f && edge_x[1] * center_x + row_edge[1] >= 0.0f && edge_x[2] * center_x + row_edge[2] >= 0.0f) {
+                row[x] = std::min(row[x], std::max(depth_x * center_x + row_depth, depth_min));
+            }
+        }
+#endif
+    }
+}
+
+// Each texel takes the nearest and farthest of the four below it, for the band's rows at every level
+void OcclusionBuffer::build_levels(int band) {
+    for (int level = 1; level < OCCLUSION_LEVELS; level += 1) {
+        int width = OCCLUSION_WIDTH >> level;
+        const std::vector<float>& below_min = level == 1 ? this->depth : this->min_depth[level - 1];
+        const std::vector<float>& below_max = level == 1 ? this->depth : this->max_depth[level - 1];
+        for (int y = (band * OCCLUSION_BAND) >> level; y < ((band + 1) * OCCLUSION_BAND) >> level; y += 1) {
+            for (int x = 0; x < width; x += 1) {
+                int first = 2 * y * 2 * width + 2 * x;
+                int second = first + 2 * width;
+                this->min_depth[level][y * width + x] = std::min(std::min(below_min[first], below_min[first + 1]), std::min(below_min[second], below_min[second + 1]));
+                this->max_depth[level][y * width + x] = std::max(std::max(below_max[first], below_max[first + 1]), std::max(below_max[second], below_max[second + 1]));
+            }
+        }
+    }
+}
+
+// Compares the box's nearest depth with the texels under its screen rectangle, widened by a pixel for the pixels
+// an occluder only partly covers. Starts at the level where the rectangle spans at most two texels each way.
+bool OcclusionBuffer::visible(const Bounds& bounds) const {
+    glm::vec2 low, high;
+    float nearest = 1.0f;
+    for (int i = 0; i < 8; i += 1) {
+        glm::vec4 clip = this->view_projection * glm::vec4(i & 1 ? bounds.max.x : bounds.min.x, i & 2 ? bounds.max.y : bounds.min.y, i & 4 ? bounds.max.z : bounds.min.z, 1.0f);
+        if (clip.w < OCCLUSION_MIN_W || clip.z < -clip.w) {
+            return true;
+        }
+        glm::vec2 screen = glm::vec2((clip.x / clip.w * 0.5f + 0.5f) * OCCLUSION_WIDTH, (clip.y / clip.w * 0.5f + 0.5f) * OCCLUSION_HEIGHT);
+        low = i == 0 ? screen : glm::min(low, screen);
+        high = i == 0 ? screen : glm::max(high, screen);
+        nearest = std::min(nearest, clip.z / clip.w);
+    }
+
+    // Off screen altogether is for frustum culling to decide
+    int x0 = (int)std::floor(low.x) - 1;
+    int x1 = (int)std::floor(high.x) + 1;
+    int y0 = (int)std::floor(low.y) - 1;
+    int y1 = (int)std::floor(high.y) + 1;
+    if (x1 < 0 || y1 < 0 || x0 >= OCCLUSION_WIDTH || y0 >= OCCLUSION_HEIGHT) {
+        return true;
+    }
+    x0 = std::max(x0, 0);
+    y0 = std::max(y0, 0);
+    x1 = std::min(x1, OCCLUSION_WIDTH - 1);
+    y1 = std::min(y1, OCCLUSION_HEIGHT - 1);
+
+    int level = 0;
+    while (level < OCCLUSION_LEVELS - 1 && ((x1 >> level) - (x0 >> level) > 1 || (y1 >> level) - (y0 >> level) > 1)) {
+        level += 1;
+    }
+    for (int y = y0 >> level; y <= y1 >> level; y += 1) {
+        for (int x = x0 >> level; x <= x1 >> level; x += 1) {
+            if (this->visible_in(level, x, y, x0, y0, x1, y1, nearest)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+// Hidden under a texel when behind its farthest depth, visible when in front of its nearest, else it depends on the
+// four texels below that overlap the rectangle
+bool OcclusionBuffer::visible_in(int level, int x, int y, int x0, int y0, int x1, int y1, float depth) const {
+    if (level == 0) {
+        return depth <= this->depth[y * OCCLUSION_WIDTH + x];
+    }
+    int texel = y * (OCCLUSION_WIDTH >> level) + x;
+    if (depth > this->max_depth[level][texel]) {
+        return false;
+    }
+    if (depth <= this->min_depth[level][texel]) {
+        return true;
+    }
+
+    int below = level - 1;
+    for (int child_y = std::max(2 * y, y0 >> below); child_y <= std::min(2 * y + 1, y1 >> below); child_y += 1) {
+        for (int child_x = std::max(2 * x, x0 >> below); child_x <= std::min(2 * x + 1, x1 >> below); child_x += 1) {
+            if (this->visible_in(below, child_x, child_y, x0, y0, x1, y1, depth)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+size_t OcclusionBuffer::getTriangleCount() const {
+    return this->triangles.size();
+}
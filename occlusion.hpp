@@ -0,0 +1,48 @@
+#include <vector>
+#include "glm/glm/glm.hpp"
+#include "frustum.hpp"
+#include "thread_pool.hpp"
+
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+// Resolution of the software depth buffer, far below the window's: one pixel covers about 5 x 5 screen pixels
+const int OCCLUSION_WIDTH = 256;
+const int OCCLUSION_HEIGHT = 160;
+
+// Rows per rasterization job. Each level of the hierarchy halves the one below, so the coarsest level has one texel
+// per OCCLUSION_BAND x OCCLUSION_BAND pixels and every band builds its own part of the hierarchy.
+const int OCCLUSION_BAND = 16;
+const int OCCLUSION_LEVELS = 5;
+
+// Corners with a clip-space w below this are at or behind the eye, where dividing by w would flip or blow up
+const float OCCLUSION_MIN_W = 1e-3f;
+
+// An occluder face in screen space: pixel coordinates and NDC depth of its corners
+struct OcclusionTriangle {
+    glm::vec3 a, b, c;
+};
+
+// Software hierarchical-Z occlusion. render() rasterizes occluder boxes into a low-resolution depth buffer,
+// keeping the nearest depth per pixel, and builds min/max depth levels over it. visible() then reports whether any
+// part of a box could be in front of what was rendered. Pixels count as covered when their center is, so an object
+// seen only through a gap narrower than a pixel can be rejected; everything else errs towards visible.
+class OcclusionBuffer {
+public:
+    OcclusionBuffer();
+    void render(const glm::mat4& view_projection, const glm::vec3& eye, const std::vector<Bounds>& occluders, ThreadPool& pool);
+    bool visible(const Bounds& bounds) const;
+    size_t getTriangleCount() const;
+private:
+    void add_occluder(const Bounds& bounds, const glm::vec3& eye);
+    void rasterize(const OcclusionTriangle& triangle, int band);
+    void build_levels(int band);
+    bool visible_in(int level, int x, int y, int x0, int y0, int x1, int y1, float depth) const;
+    glm::mat4 view_projection;
+    std::vector<OcclusionTriangle> triangles;
+    std::vector<float> depth; // nearest occluder per pixel, 1 (the far plane) where there is none
+    std::vector<float> min_depth[OCCLUSION_LEVELS]; // nearest and farthest depth under each texel, level 0 unused
+    std::vector<float> max_depth[OCCLUSION_LEVELS];
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include <iostream>
+#include <string>
+#include <stdexcept>
+
+#include "options.hpp"
+
+void print_usage(const char* program) {
+    std::cout << "Usage: " << program << " [options]\n"
+              << "  --seed N          generate the world from seed N (random otherwise)\n"
+              << "  --buildings N     number of buildings (default 100)\n"
+              << "  --world-size N    side length of the square world (default 1000)\n"
+              << "  --threads N       generate the world on N threads (default: all cores, same world for any N)\n"
+              << "  --indexed         draw shared-vertex cubes with glDrawElements\n"
+              << "  --instanced       draw one unit cube per box with glDrawElementsInstanced\n"
+              << "  --packed          16-byte quantized vertices instead of 36-byte floats (arrays and indexed modes)\n"
+              << "  --stream          stage placed blocks through the mapped ring buffer\n"
+              << "  --stress N        place N random blocks per second and report upload cost\n"
+              << "  --churn N         with --stress, remove a random stress block for each one placed beyond N\n"
+              << "  --no-cull         draw everything instead of frustum culling\n"
+              << "  --occlusion       also skip boxes hidden behind the nearest buildings (software depth buffer)\n"
+              << "  --cull-stats      print culling counters every second\n"
+              << "  --headless        render offscreen along a scripted camera path, print frame timings and exit\n"
+              << "  --frames N        frames to render in --headless mode (default 600)\n"
+              << "  --profile         report p50/p95/p99 CPU and GPU frame times and per-stage CPU time on exit\n"
+              << "  --profile-csv F   also write every frame's timings to CSV file F\n"
+              << "  --trace FILE      write trace zones as Chrome trace JSON on exit (needs -DFRAGMENT_TRACE=ON)\n"
+              << "  --help            show this message" << std::endl;
+}
+
+// Returns false after printing a message when an argument is unknown or its value does not parse
+bool parse_options(int argc, char* argv[], Options& options) {
+    for (int i = 1; i < argc; i += 1) {
+        std::string arg = argv[i];
+        bool takes_value = arg == "--seed" || arg == "--buildings" || arg == "--world-size" || arg == "--threads" || arg == "--stress" || arg == "--churn" || arg == "--frames" || arg == "--profile-csv" || arg == "--trace";
+        if (takes_value && i + 1 >= argc) {
+            std::cout << arg << " needs a value" << std::endl;
+            return false;
+        }
+
+        try {
+            if (arg == "--seed") {
+                options.has_seed = true;
+                options.seed = std::stoull(argv[++i]);
+            } else if (arg == "--buildings") {
+                options.buildings = std::stoi(argv[++i]);
+            } else if (arg == "--world-size") {
+                options.world_size = std::stof(argv[++i]);
+            } else if (arg == "--threads") {
+                options.threads = std::stoi(argv[++i]);
+            } else if (arg == "--stress") {
+                options.stress_rate = std::stof(argv[++i]);
+            } else if (arg == "--churn") {
+                options.churn = std::stoi(argv[++i]);
+            } else if (arg == "--headless") {
+                options.headless = true;
+            } else if (arg == "--frames") {
+                options.frames = std::stoi(argv[++i]);
+            } else if (arg == "--profile") {
+                options.profile = true;
+            } else if (arg == "--profile-csv") {
+                options.profile = true;
+                options.profile_csv = argv[++i];
+            } else if (arg == "--trace") {
+                options.trace_path = argv[++i];
+            } else if (arg == "--indexed") {
+                options.geometry_mode = INDEXED;
+            } else if (arg == "--instanced") {
+                options.geometry_mode = INSTANCED;
+            } else if (arg == "--packed") {
+                options.packed_vertices = true;
+            } else if (arg == "--stream") {
+                options.streaming = true;
+            } else if (arg == "--no-cull") {
+                options.culling = false;
+            } else if (arg == "--occlusion") {
+                options.occlusion = true;
+            } else if (arg == "--cull-stats") {
+                options.cull_stats = true;
+            } else if (arg == "--help") {
+                print_usage(argv[0]);
+                return false;
+            } else {
+                std::cout << "Unknown option " << arg << std::endl;
+                print_usage(argv[0]);
+                return false;
+            }
+        } catch (const std::exception&) {
+            std::cout << "Invalid value for " << arg << ": " << argv[i] << std::endl;
+            return false;
+        }
+    }
+
+    if (options.buildings < 0 || options.threads < 0 || options.churn < 0 || options.world_size <= 0.0f || options.frames <= 0) {
+        std::cout << "--buildings, --threads and --churn must not be negative, --world-size and --frames must be positive" << std::endl;
+        return false;
+    }
+
+    return true;
+}
@@ -0,0 +1,33 @@
+#include <cstdint>
+#include <string>
+#include "world.hpp"
+
+#ifndef OPTIONS_H
+#define OPTIONS_H
+
+// Command line settings. Anything left unset keeps the interactive defaults.
+struct Options {
+    bool has_seed = false;
+    uint64_t seed = 0;
+    int buildings = 100;
+    float world_size = 1000.0f;
+    int threads = 0; // 0 uses every hardware thread
+    GeometryMode geometry_mode = ARRAYS;
+    bool streaming = false;
+    bool packed_vertices = false;
+    bool culling = true;
+    bool occlusion = false;
+    bool cull_stats = false;
+    float stress_rate = 0.0f;
+    int churn = 0; // with --stress, live stress blocks above which each placement removes a random earlier one
+    bool headless = false;
+    int frames = 600;
+    bool profile = false;
+    std::string profile_csv;
+    std::string trace_path;
+};
+
+bool parse_options(int argc, char* argv[], Options& options);
+void print_usage(const char* program);
+
+#endif
@@ -0,0 +1,191 @@
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#ifdef __APPLE__
+    #include <OpenGL/gl3.h>
+#else
+    #include <OpenGL/gl.h>
+#endif
+
+#include "profiler.hpp"
+
+static double elapsed_ms(std::chrono::steady_clock::time_point since) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+// Nearest-rank percentile of an already sorted list
+static double percentile(const std::vector<double>& sorted, double p) {
+    if (sorted.empty()) {
+        return 0.0;
+    }
+    size_t rank = (size_t)(p / 100.0 * (sorted.size() - 1) + 0.5);
+    return sorted[rank];
+}
+
+void FrameProfiler::set_enabled(bool enabled) {
+    this->enabled = enabled;
+}
+
+void FrameProfiler::begin_frame() {
+    if (!this->enabled) {
+        return;
+    }
+
+    this->current = {};
+    this->current.gpu_ms = -1.0;
+    this->frame_start = std::chrono::steady_clock::now();
+    this->stage_start = this->frame_start;
+}
+
+// Charges the time since the previous mark (or the start of the frame) to stage
+void FrameProfiler::mark(ProfileStage stage) {
+    if (!this->enabled) {
+        return;
+    }
+
+    auto now = std::chrono::steady_clock::now();
+    this->current.stage_ms[stage] += std::chrono::duration<double, std::milli>(now - this->stage_start).count();
+    this->stage_start = now;
+}
+
+void FrameProfiler::begin_gpu() {
+    if (!this->enabled) {
+        return;
+    }
+
+    if (this->queries[0] == 0) {
+        glGenQueries(GPU_QUERIES, this->queries);
+        std::fill(this->query_frames, this->query_frames + GPU_QUERIES, -1);
+    }
+
+    this->collect(false);
+    if (this->query_frames[this->next_query] != -1) {
+        this->skipped_queries += 1;
+        return;
+    }
+
+    glBeginQuery(GL_TIME_ELAPSED, this->queries[this->next_query]);
+    this->query_frames[this->next_query] = this->samples.size();
+    this->query_starts[this->next_query] = std::chrono::steady_clock::now();
+    this->query_active = true;
+}
+
+void FrameProfiler::end_gpu() {
+    if (!this->query_active) {
+        return;
+    }
+
+    glEndQuery(GL_TIME_ELAPSED);
+    this->next_query = (this->next_query + 1) % GPU_QUERIES;
+    this->query_active = false;
+}
+
+void FrameProfiler::end_frame(size_t draw_calls, size_t vertices) {
+    if (!this->enabled) {
+        return;
+    }
+
+    this->current.frame_ms = elapsed_ms(this->frame_start);
+    this->current.draw_calls = draw_calls;
+    this->current.vertices = vertices;
+    this->samples.push_back(this->current);
+}
+
+// Waits for the queries still in flight, so the last frames get their GPU time too
+void FrameProfiler::finish() {
+    if (this->enabled && this->queries[0] != 0) {
+        this->collect(true);
+    }
+}
+
+void FrameProfiler::report() {
+    if (this->samples.empty()) {
+        return;
+    }
+
+    std::vector<double> frame_ms, gpu_ms;
+    double stage_ms[STAGE_COUNT] = {};
+    double draw_calls = 0.0, vertices = 0.0;
+    for (const FrameSample& sample : this->samples) {
+        frame_ms.push_back(sample.frame_ms);
+        if (sample.gpu_ms >= 0.0) {
+            gpu_ms.push_back(sample.gpu_ms);
+        }
+        for (int stage = 0; stage < STAGE_COUNT; stage += 1) {
+            stage_ms[stage] += sample.stage_ms[stage];
+        }
+        draw_calls += sample.draw_calls;
+        vertices += sample.vertices;
+    }
+    std::sort(frame_ms.begin(), frame_ms.end());
+    std::sort(gpu_ms.begin(), gpu_ms.end());
+    double frames = this->samples.size();
+
+    std::cout << "Profile: " << this->samples.size() << " frames, frame ms p50 " << percentile(frame_ms, 50) << " p95 " << percentile(frame_ms, 95)
+              << " p99 " << percentile(frame_ms, 99) << std::endl;
+    std::cout << "  CPU ms avg: input " << stage_ms[STAGE_INPUT] / frames << ", update " << stage_ms[STAGE_UPDATE] / frames
+              << ", uniforms " << stage_ms[STAGE_UNIFORMS] / frames << ", draw " << stage_ms[STAGE_DRAW] / frames
+              << ", present " << stage_ms[STAGE_PRESENT] / frames << std::endl;
+    std::cout << "  GPU ms p50 " << percentile(gpu_ms, 50) << " p95 " << percentile(gpu_ms, 95) << " p99 " << percentile(gpu_ms, 99)
+              << " (" << gpu_ms.size() << " frames timed, " << this->skipped_queries << " skipped, "
+              << this->rejected_queries << " implausible results dropped)" << std::endl;
+    std::cout << "  per frame avg: " << draw_calls / frames << " draw calls, " << vertices / frames << " vertices" << std::endl;
+}
+
+// One row per frame; gpu_ms is empty for frames without a timer result
+bool FrameProfiler::write_csv(const std::string& path) {
+    std::ofstream file(path);
+    if (!file) {
+        std::cout << "Failed to open " << path << " for writing" << std::endl;
+        return false;
+    }
+
+    file << "frame,frame_ms,input_ms,update_ms,uniforms_ms,draw_ms,present_ms,gpu_ms,draw_calls,vertices\n";
+    for (size_t i = 0; i < this->samples.size(); i += 1) {
+        const FrameSample& sample = this->samples[i];
+        file << i << "," << sample.frame_ms;
+        for (int stage = 0; stage < STAGE_COUNT; stage += 1) {
+            file << "," << sample.stage_ms[stage];
+        }
+        file << ",";
+        if (sample.gpu_ms >= 0.0) {
+            file << sample.gpu_ms;
+        }
+        file << "," << sample.draw_calls << "," << sample.vertices << "\n";
+    }
+
+    return true;
+}
+
+bool FrameProfiler::isEnabled() {
+    return this->enabled;
+}
+
+void FrameProfiler::collect(bool wait) {
+    for (int i = 0; i < GPU_QUERIES; i += 1) {
+        if (this->query_frames[i] == -1 || (this->query_active && i == this->next_query)) {
+            continue;
+        }
+
+        if (!wait) {
+            GLint available = 0;
+            glGetQueryObjectiv(this->queries[i], GL_QUERY_RESULT_AVAILABLE, &available);
+            if (!available) {
+                continue;
+            }
+        }
+
+        GLuint64 nanoseconds = 0;
+        glGetQueryObjectui64v(this->queries[i], GL_QUERY_RESULT, &nanoseconds);
+
+        // GPU work cannot take longer than the wall time since the query began. Some drivers (llvmpipe,
+        // on a context's first frame) report garbage that would otherwise swamp the percentiles.
+        double gpu_ms = nanoseconds / 1000000.0;
+        if (gpu_ms > elapsed_ms(this->query_starts[i])) {
+            this->rejected_queries += 1;
+        } else if ((size_t)this->query_frames[i] < this->samples.size()) {
+            this->samples[this->query_frames[i]].gpu_ms = gpu_ms;
+        }
+        this->query_frames[i] = -1;
+    }
+}
@@ -0,0 +1,60 @@
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstddef>
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+// CPU stages of a frame, in the order the render loop runs them
+enum ProfileStage {
+    STAGE_INPUT, // process_input or the scripted camera
+    STAGE_UPDATE, // stress placement and its upload
+    STAGE_UNIFORMS,
+    STAGE_DRAW, // clear, chunk uploads and draw submission
+    STAGE_PRESENT, // glfwSwapBuffers and event polling, or glFinish when headless
+    STAGE_COUNT
+};
+
+struct FrameSample {
+    double frame_ms;
+    double stage_ms[STAGE_COUNT];
+    double gpu_ms; // negative when the frame's timer query was skipped or has not arrived
+    size_t draw_calls;
+    size_t vertices;
+};
+
+// Timer queries in flight; a frame whose slot is still busy goes without GPU time rather than waiting
+const int GPU_QUERIES = 8;
+
+// Records CPU time per stage and GL_TIME_ELAPSED GPU time for every frame while enabled.
+// Query results are picked up once available and never waited on until finish().
+class FrameProfiler {
+public:
+    void set_enabled(bool enabled);
+    void begin_frame();
+    void mark(ProfileStage stage);
+    void begin_gpu();
+    void end_gpu();
+    void end_frame(size_t draw_calls, size_t vertices);
+    void finish();
+    void report();
+    bool write_csv(const std::string& path);
+    bool isEnabled();
+private:
+    void collect(bool wait);
+    bool enabled = false;
+    std::vector<FrameSample> samples;
+    FrameSample current = {};
+    std::chrono::steady_clock::time_point frame_start;
+    std::chrono::steady_clock::time_point stage_start;
+    unsigned int queries[GPU_QUERIES] = {};
+    long long query_frames[GPU_QUERIES] = {}; // sample each query times, -1 when the slot is free
+    std::chrono::steady_clock::time_point query_starts[GPU_QUERIES];
+    int next_query = 0;
+    bool query_active = false;
+    size_t skipped_queries = 0;
+    size_t rejected_queries = 0;
+};
+
+#endif
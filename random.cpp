@@ -0,0 +1,110 @@
+#include <atomic>
+
+#include "random.hpp"
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// splitmix64 spreads a small seed over the full 256-bit state, as recommended by the xoshiro authors
+static uint64_t splitmix64(uint64_t& x) {
+    uint64_t z = (x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+Random::Random(uint64_t seed, uint64_t stream) {
+    for (int i = 0; i < 4; i += 1) {
+        this->state[i] = splitmix64(seed);
+    }
+
+    for (uint64_t i = 0; i < stream; i += 1) {
+        this->jump();
+    }
+}
+
+// The key is mixed into the seed rather than jumped to, so any item's generator is cheap to create
+Random Random::keyed(uint64_t seed, uint64_t key) {
+    uint64_t mixed = key;
+    return Random(seed ^ splitmix64(mixed));
+}
+
+uint64_t Random::next() {
+    uint64_t result = rotl(this->state[1] * 5, 7) * 9;
+    uint64_t t = this->state[1] << 17;
+
+    this->state[2] ^= this->state[0];
+    this->state[3] ^= this->state[1];
+    this->state[1] ^= this->state[2];
+    this->state[0] ^= this->state[3];
+    this->state[2] ^= t;
+    this->state[3] = rotl(this->state[3], 45);
+
+    return result;
+}
+
+// Uniform in [0, 1): the top 24 bits fill a float's mantissa exactly
+float Random::next_float() {
+    return (this->next() >> 40) * (1.0f / 16777216.0f);
+}
+
+float Random::next_float(float min, float max) {
+    return min + (max - min) * this->next_float();
+}
+
+void Random::next_floats(float* out, size_t count, float min, float max) {
+    float scale = (max - min) * (1.0f / 16777216.0f);
+    for (size_t i = 0; i < count; i += 1) {
+        out[i] = min + (this->next() >> 40) * scale;
+    }
+}
+
+// Equivalent to 2^128 calls to next()
+void Random::jump() {
+    static const uint64_t JUMP[] = {0x180ec6d33cfd0abaULL, 0xd5a61266f0c9392cULL, 0xa9582618e03fc9aaULL, 0x39abdc4529b1661cULL};
+
+    uint64_t s[4] = {0, 0, 0, 0};
+    for (int i = 0; i < 4; i += 1) {
+        for (int b = 0; b < 64; b += 1) {
+            if (JUMP[i] & (1ULL << b)) {
+                s[0] ^= this->state[0];
+                s[1] ^= this->state[1];
+                s[2] ^= this->state[2];
+                s[3] ^= this->state[3];
+            }
+            this->next();
+        }
+    }
+
+    for (int i = 0; i < 4; i += 1) {
+        this->state[i] = s[i];
+    }
+}
+
+static std::atomic<uint64_t> world_seed(0);
+static std::atomic<unsigned int> seed_generation(1);
+static std::atomic<uint64_t> next_stream(0);
+
+void seed_random(uint64_t seed) {
+    world_seed = seed;
+    next_stream = 0;
+    seed_generation += 1;
+}
+
+uint64_t random_seed() {
+    return world_seed;
+}
+
+// Threads pick up a fresh stream the first time they draw after (re)seeding
+Random& thread_random() {
+    thread_local Random random = Random(0);
+    thread_local unsigned int generation = 0;
+
+    if (generation != seed_generation) {
+        generation = seed_generation;
+        random = Random(world_seed, next_stream++);
+    }
+
+    return random;
+}
@@ -0,0 +1,28 @@
+#include <cstdint>
+#include <cstddef>
+
+#ifndef RANDOM_H
+#define RANDOM_H
+
+// xoshiro256** by Blackman and Vigna: a few shifts and rotates per number, fully reproducible from a seed.
+// Stream n of a seed starts n jumps of 2^128 numbers in, so streams handed to different threads never overlap.
+// keyed() gives one short sequence per item (a building, say), the same whichever thread or order generates it.
+class Random {
+public:
+    Random(uint64_t seed, uint64_t stream = 0);
+    static Random keyed(uint64_t seed, uint64_t key);
+    uint64_t next();
+    float next_float();
+    float next_float(float min, float max);
+    void next_floats(float* out, size_t count, float min, float max);
+    void jump();
+private:
+    uint64_t state[4];
+};
+
+// The world seed. Every thread draws from its own stream of it through thread_random().
+void seed_random(uint64_t seed);
+uint64_t random_seed();
+Random& thread_random();
+
+#endif
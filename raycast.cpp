@@ -0,0 +1,72 @@
+#include <cmath>
+#include <limits>
+#include <algorithm>
+
+#include "raycast.hpp"
+
+// A ray parallel to an axis has an infinite inverse direction there and never steps along it
+GridWalk::GridWalk(const glm::vec3& origin, const glm::vec3& inverse_direction, float size, const glm::ivec3& cell, float distance) {
+    const float infinity = std::numeric_limits<float>::infinity();
+    for (int a = 0; a < 3; a += 1) {
+        this->cell[a] = cell[a];
+        if (std::isinf(inverse_direction[a])) {
+            this->step[a] = 0;
+            this->next[a] = infinity;
+            this->delta[a] = infinity;
+            continue;
+        }
+        this->step[a] = inverse_direction[a] > 0.0f ? 1 : -1;
+        float boundary = (cell[a] + (this->step[a] > 0 ? 1 : 0)) * size;
+        this->next[a] = (boundary - origin[a]) * inverse_direction[a];
+        this->delta[a] = size * std::fabs(inverse_direction[a]);
+    }
+    this->axis = -1;
+    this->distance = distance;
+}
+
+void GridWalk::advance() {
+    int a = this->next[0] < this->next[1] ? 0 : 1;
+    a = this->next[2] < this->next[a] ? 2 : a;
+    this->axis = a;
+    this->distance = this->next[a];
+    this->cell[a] += this->step[a];
+    this->next[a] += this->delta[a];
+}
+
+glm::ivec3 grid_cell(const glm::vec3& position, float size) {
+    return glm::ivec3((int)std::floor(position.x / size), (int)std::floor(position.y / size), (int)std::floor(position.z / size));
+}
+
+// An axis the ray runs parallel to gives infinite slab distances, or NaN exactly on a face, which the comparisons ignore
+bool clip_ray(const Bounds& bounds, const glm::vec3& origin, const glm::vec3& inverse_direction, float max_distance, float& enter, float& leave, int& axis) {
+    enter = 0.0f;
+    leave = max_distance;
+    axis = -1;
+    for (int a = 0; a < 3; a += 1) {
+        float t0 = (bounds.min[a] - origin[a]) * inverse_direction[a];
+        float t1 = (bounds.max[a] - origin[a]) * inverse_direction[a];
+        if (inverse_direction[a] < 0.0f) {
+            std::swap(t0, t1);
+        }
+        if (t0 > enter) {
+            enter = t0;
+            axis = a;
+        }
+        if (t1 < leave) {
+            leave = t1;
+        }
+        if (enter > leave) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void set_box_hit(const glm::vec3& origin, const glm::vec3& direction, float distance, int axis, RayHit& hit) {
+    hit.distance = distance;
+    hit.point = origin + direction * distance;
+    hit.normal = glm::ivec3(0);
+    hit.normal[axis] = direction[axis] > 0.0f ? -1 : 1;
+    hit.cell = grid_cell(hit.point - glm::vec3(hit.normal) * 0.5f, 1.0f);
+    hit.block = false;
+}
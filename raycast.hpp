@@ -0,0 +1,41 @@
+#include "glm/glm/glm.hpp"
+#include "frustum.hpp"
+
+#ifndef RAYCAST_H
+#define RAYCAST_H
+
+// Where a ray first meets the world. cell is the block that was hit, or for a building the grid cell just behind
+// the hit point; normal is the face the ray entered through, so cell + normal is where a block attaches.
+// normal is zero when the ray starts inside a block.
+struct RayHit {
+    float distance;
+    glm::vec3 point;
+    glm::ivec3 cell;
+    glm::ivec3 normal;
+    bool block; // a placed block rather than a building
+};
+
+// Amanatides-Woo traversal of a grid of size-wide cells: each advance() steps into the next cell the ray crosses.
+// distance is where the ray entered the current cell and axis the axis it crossed to get there, -1 for the first cell.
+struct GridWalk {
+    int cell[3];
+    int step[3];
+    float next[3]; // distance at which the ray leaves the current cell along each axis
+    float delta[3]; // distance between two boundaries along each axis
+    int axis;
+    float distance;
+
+    GridWalk(const glm::vec3& origin, const glm::vec3& inverse_direction, float size, const glm::ivec3& cell, float distance);
+    void advance();
+};
+
+glm::ivec3 grid_cell(const glm::vec3& position, float size);
+
+// Slab test against a box: [enter, leave] is the part of the ray up to max_distance inside it, and axis the axis
+// the ray enters it through, -1 if the ray starts inside.
+bool clip_ray(const Bounds& bounds, const glm::vec3& origin, const glm::vec3& inverse_direction, float max_distance, float& enter, float& leave, int& axis);
+
+// Fills in a hit on a box entered through axis at distance
+void set_box_hit(const glm::vec3& origin, const glm::vec3& direction, float distance, int axis, RayHit& hit);
+
+#endif
@@ -1,6 +1,7 @@
 #include <iostream>
 #include <fstream>
 #include <string>
+#include <cstring>
 #ifdef __APPLE__
     #include <OpenGL/gl3.h>
 #else
@@ -8,6 +9,8 @@
 #endif
 
 #include "shader.hpp"
+#include "trace.hpp"
+#include "glm/glm/gtc/type_ptr.hpp"
 
 bool check_compile_error(unsigned int shader) {
     int success;
@@ -22,17 +25,30 @@ bool check_compile_error(unsigned int shader) {
     return true;
 }
 
-Shader::Shader(std::string vertex_shader, std::string fragment_shader) {
+// #version has to stay the first line, so defines go right after it
+static std::string add_defines(const std::string& source, const std::string& defines) {
+    size_t line_end = source.find('\n');
+    if (defines.empty() || line_end == std::string::npos) {
+        return source;
+    }
+    return source.substr(0, line_end + 1) + defines + source.substr(line_end + 1);
+}
+
+Shader::Shader(std::string vertex_shader, std::string fragment_shader, std::string defines) {
     this->vertex_shader = vertex_shader;
     this->fragment_shader = fragment_shader;
+    this->defines = defines;
 }
 
 bool Shader::compile_shaders() {
+    TRACE_ZONE("Shader::compile_shaders");
     // Read shaders into variables v_content and f_content
     std::ifstream v_ifs(this->vertex_shader);
     std::string v_content((std::istreambuf_iterator<char>(v_ifs)), (std::istreambuf_iterator<char>()));
     std::ifstream f_ifs(this->fragment_shader);
     std::string f_content((std::istreambuf_iterator<char>(f_ifs)), (std::istreambuf_iterator<char>()));
+    v_content = add_defines(v_content, this->defines);
+    f_content = add_defines(f_content, this->defines);
 
     bool compileSuccess = true;
     
@@ -66,6 +82,13 @@ bool Shader::compile_shaders() {
     }
 
     this->program = shaderProgram;
+    this->reflect_uniforms();
+
+    // GLSL 330 has no layout(binding) for blocks, so the binding point is assigned here for every program
+    unsigned int frame_block = glGetUniformBlockIndex(shaderProgram, "Frame");
+    if (frame_block != GL_INVALID_INDEX) {
+        glUniformBlockBinding(shaderProgram, frame_block, FRAME_UNIFORM_BINDING);
+    }
 
     // Clean up
     glDeleteShader(vertex);
@@ -74,42 +97,103 @@ bool Shader::compile_shaders() {
 
 }
 
-void Shader::bind_buffers(std::vector<Vertex> vertices) {
-    unsigned int VBO, VAO;
-    glGenVertexArrays(1, &VAO);
-    glGenBuffers(1, &VBO);
-    // bind the Vertex Array Object first, then bind and set vertex buffer(s), and then configure vertex attributes(s).
-    glBindVertexArray(VAO);
-    this->VAO = VAO;
-
-    glBindBuffer(GL_ARRAY_BUFFER, VBO);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(Vertex) * vertices.size(), vertices.data(), GL_STATIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)0);
-    glEnableVertexAttribArray(0);
+unsigned int Shader::getProgram() {
+    return this->program;
+}
 
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(3 * sizeof(float)));
-    glEnableVertexAttribArray(1);
+// Returns -1 for names the linker dropped or never saw; setters ignore -1 the way glUniform* ignores location -1
+int Shader::getUniform(const std::string& name) {
+    auto found = this->uniform_indices.find(name);
+    if (found == this->uniform_indices.end()) {
+        return -1;
+    }
+    return found->second;
+}
 
-    glVertexAttribPointer(2, 3, GL_FLOAT, GL_FALSE, sizeof(Vertex), (void*)(6 * sizeof(float)));
-    glEnableVertexAttribArray(2);
+void Shader::set_uniform(int uniform, const glm::mat4& value) {
+    if (this->shadow(uniform, GL_FLOAT_MAT4, glm::value_ptr(value), sizeof(value))) {
+        glUniformMatrix4fv(this->uniforms[uniform].location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+}
 
-    // note that this is allowed, the call to glVertexAttribPointer registered VBO as the vertex attribute's bound vertex buffer object so afterwards we can safely unbind
-    glBindBuffer(GL_ARRAY_BUFFER, 0); 
+void Shader::set_uniform(int uniform, const glm::mat3& value) {
+    if (this->shadow(uniform, GL_FLOAT_MAT3, glm::value_ptr(value), sizeof(value))) {
+        glUniformMatrix3fv(this->uniforms[uniform].location, 1, GL_FALSE, glm::value_ptr(value));
+    }
+}
 
-    // remember: do NOT unbind the EBO while a VAO is active as the bound element buffer object IS stored in the VAO; keep the EBO bound.
-    //glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+void Shader::set_uniform(int uniform, const glm::vec3& value) {
+    if (this->shadow(uniform, GL_FLOAT_VEC3, glm::value_ptr(value), sizeof(value))) {
+        glUniform3fv(this->uniforms[uniform].location, 1, glm::value_ptr(value));
+    }
+}
 
-    // You can unbind the VAO afterwards so other VAO calls won't accidentally modify this VAO, but this rarely happens. Modifying other
-    // VAOs requires a call to glBindVertexArray anyways so we generally don't unbind VAOs (nor VBOs) when it's not directly necessary.
-    glBindVertexArray(0);
+void Shader::set_uniform(int uniform, float value) {
+    if (this->shadow(uniform, GL_FLOAT, &value, sizeof(value))) {
+        glUniform1f(this->uniforms[uniform].location, value);
+    }
+}
 
+void Shader::set_uniform(int uniform, int value) {
+    if (this->shadow(uniform, GL_INT, &value, sizeof(value))) {
+        glUniform1i(this->uniforms[uniform].location, value);
+    }
 }
 
-unsigned int Shader::getProgram() {
-    return this->program;
+const std::vector<Uniform>& Shader::getUniforms() {
+    return this->uniforms;
 }
 
-unsigned int Shader::getVAO() {
-    return this->VAO;
+// Active uniforms outside any uniform block, looked up once so nothing is resolved by name per frame
+void Shader::reflect_uniforms() {
+    this->uniforms.clear();
+    this->uniform_indices.clear();
+
+    int count = 0;
+    glGetProgramiv(this->program, GL_ACTIVE_UNIFORMS, &count);
+    for (int i = 0; i < count; i += 1) {
+        char name[256];
+        int length = 0, size = 0;
+        unsigned int type = 0;
+        glGetActiveUniform(this->program, i, sizeof(name), &length, &size, &type, name);
+
+        int location = glGetUniformLocation(this->program, name);
+        if (location == -1) {
+            continue;
+        }
+
+        // Arrays are reported as name[0]; look them up by their bare name
+        std::string uniform_name(name, length);
+        if (uniform_name.size() > 3 && uniform_name.compare(uniform_name.size() - 3, 3, "[0]") == 0) {
+            uniform_name.resize(uniform_name.size() - 3);
+        }
+
+        Uniform uniform;
+        uniform.name = uniform_name;
+        uniform.location = location;
+        uniform.type = type;
+        this->uniform_indices[uniform_name] = this->uniforms.size();
+        this->uniforms.push_back(uniform);
+    }
 }
+
+// True when the GL call has to be made: the handle is valid, the type matches and the value differs from the last one sent
+bool Shader::shadow(int uniform, unsigned int type, const void* value, size_t size) {
+    if (uniform < 0 || uniform >= (int)this->uniforms.size()) {
+        return false;
+    }
+
+    Uniform& entry = this->uniforms[uniform];
+    if (entry.type != type) {
+        std::cout << "Uniform " << entry.name << " set with the wrong type" << std::endl;
+        return false;
+    }
+
+    if (entry.assigned && std::memcmp(entry.value, value, size) == 0) {
+        return false;
+    }
+
+    std::memcpy(entry.value, value, size);
+    entry.assigned = true;
+    return true;
+}
\ No newline at end of file
@@ -1,22 +1,59 @@
 #include <string>
 #include <vector>
-#include "vertex.hpp"
+#include <unordered_map>
+#include "glm/glm/glm.hpp"
 
 #ifndef SHADER_H
 #define SHADER_H
 
+// Uniform block binding point of the per-frame data. compile_shaders assigns it to any block named Frame.
+const unsigned int FRAME_UNIFORM_BINDING = 0;
+
+// The Frame block as laid out by std140 (see shaders/basic.vs). Only mat4 and vec4 members, so no padding is needed.
+struct FrameUniforms {
+    glm::mat4 view;
+    glm::mat4 projection;
+    glm::mat4 view_projection;
+    glm::vec4 camera_position; // w unused
+    glm::vec4 light_position; // w unused
+    glm::vec4 light_params; // ambient strength, specular strength, shininess, unused
+};
+
+static_assert(sizeof(FrameUniforms) == 240, "FrameUniforms must match the std140 Frame block");
+
+// An active uniform reflected after linking. value shadows what was last sent to the program.
+struct Uniform {
+    std::string name;
+    int location;
+    unsigned int type; // GL_FLOAT_MAT4, GL_FLOAT_VEC3, ...
+    bool assigned = false;
+    unsigned char value[64];
+};
+
 class Shader {
 public:
-    Shader(std::string vertex_shader, std::string fragment_shader);
+    // defines is spliced in after each stage's #version line to select shader variants, e.g. "#define WORLD_SPACE\n"
+    Shader(std::string vertex_shader, std::string fragment_shader, std::string defines = "");
     bool compile_shaders();
-    void bind_buffers(std::vector<Vertex> vertices);
     unsigned int getProgram();
-    unsigned int getVAO();
+    // Setters take a handle from getUniform and skip the GL call when the value has not changed.
+    // As with glUniform*, the program must be in use.
+    int getUniform(const std::string& name);
+    void set_uniform(int uniform, const glm::mat4& value);
+    void set_uniform(int uniform, const glm::mat3& value);
+    void set_uniform(int uniform, const glm::vec3& value);
+    void set_uniform(int uniform, float value);
+    void set_uniform(int uniform, int value);
+    const std::vector<Uniform>& getUniforms();
 private:
+    void reflect_uniforms();
+    bool shadow(int uniform, unsigned int type, const void* value, size_t size);
     unsigned int program;
-    unsigned int VAO;
     std::string vertex_shader;
     std::string fragment_shader;
+    std::string defines;
+    std::vector<Uniform> uniforms;
+    std::unordered_map<std::string, int> uniform_indices;
 };
 
-#endif
\ No newline at end of file
+#endif
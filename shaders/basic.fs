@@ -5,25 +5,32 @@ in vec3 fragPos;
 
 out vec4 FragColor;
 
-uniform vec3 camera_position;
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 lightPosition;
+    vec4 lightParams; // ambient strength, specular strength, shininess
+};
 
 void main() {
     // Ambient
-    float ambientStrength = 0.25;
+    float ambientStrength = lightParams.x;
     vec3 ambient = vec3(1.0f, 1.0f, 1.0f) * ambientStrength;
     
     // Diffuse 
     vec3 norm = normalize(normal);
-    vec3 lightDir = normalize(vec3(10.0f, 100.0f, 10.0f) - fragPos);
+    vec3 lightDir = normalize(lightPosition.xyz - fragPos);
 
     float diff = max(dot(norm, lightDir), 0.0);
     vec3 diffuse = diff * vec3(1.0f, 1.0f, 1.0f);
 
     // Specular
-    float specularStrength = 0.5;
-    vec3 viewDir = normalize(camera_position - fragPos);
+    float specularStrength = lightParams.y;
+    vec3 viewDir = normalize(cameraPosition.xyz - fragPos);
     vec3 reflectDir = reflect(-lightDir, norm);  
-    float spec = pow(max(dot(viewDir, reflectDir), 0.0), 32);
+    float spec = pow(max(dot(viewDir, reflectDir), 0.0), lightParams.z);
     vec3 specular = specularStrength * spec * vec3(1.0f, 1.0f, 1.0f);
 
     vec3 result = (ambient + diffuse + specular) * color;
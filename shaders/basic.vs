@@ -2,19 +2,50 @@
 layout (location = 0) in vec3 aPosition;
 layout (location = 1) in vec3 aColor;
 layout (location = 2) in vec3 aNormal;
+// Per-instance box, left at identity values when drawing world-space geometry
+layout (location = 3) in vec3 aInstanceOrigin;
+layout (location = 4) in vec3 aInstanceSize;
+layout (location = 5) in vec3 aInstanceColor;
 
 out vec3 color;
 out vec3 normal;
 out vec3 fragPos;
 
+// Shared by every program, updated once per frame (FrameUniforms in shader.hpp)
+layout (std140) uniform Frame {
+    mat4 view;
+    mat4 projection;
+    mat4 viewProjection;
+    vec4 cameraPosition;
+    vec4 lightPosition;
+    vec4 lightParams;
+};
+
+// Variants, selected with Shader defines:
+//   WORLD_SPACE              positions and normals are already in world space (the chunk meshes), no model transform
+//   PER_VERTEX_NORMAL_MATRIX derives the normal matrix per vertex; only kept as the baseline for bench/vertex_bench
+//   (default)                model transform with the normal matrix computed once on the CPU
+#ifndef WORLD_SPACE
 uniform mat4 model;
-uniform mat4 view;
-uniform mat4 projection;
+#ifndef PER_VERTEX_NORMAL_MATRIX
+uniform mat3 normalMatrix;
+#endif
+#endif
 
 void main() {
-    fragPos = vec3(model * vec4(aPosition, 1.0f));
-    color = aColor;
-    normal = mat3(transpose(inverse(model))) * aNormal;  
+    vec3 position = aInstanceOrigin + aPosition * aInstanceSize;
+    color = aColor * aInstanceColor;
+#ifdef WORLD_SPACE
+    fragPos = position;
+    normal = aNormal;
+#else
+    fragPos = vec3(model * vec4(position, 1.0f));
+#ifdef PER_VERTEX_NORMAL_MATRIX
+    normal = mat3(transpose(inverse(model))) * aNormal;
+#else
+    normal = normalMatrix * aNormal;
+#endif
+#endif
 
-    gl_Position = projection * view * vec4(fragPos, 1.0);
+    gl_Position = viewProjection * vec4(fragPos, 1.0);
 }
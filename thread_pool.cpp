@@ -0,0 +1,88 @@
+#include <algorithm>
+
+#include "thread_pool.hpp"
+
+ThreadPool::ThreadPool(unsigned int threads) {
+    if (threads == 0) {
+        threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (unsigned int i = 1; i < threads; i += 1) {
+        this->workers.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        this->stopping = true;
+    }
+    this->job_ready.notify_all();
+
+    for (std::thread& worker : this->workers) {
+        worker.join();
+    }
+}
+
+// Blocks until body has run over all of [0, count). Ranges are fixed by count and thread count alone.
+void ThreadPool::parallel_for(size_t count, const std::function<void(size_t begin, size_t end)>& body) {
+    size_t ranges = std::min<size_t>(count, this->getThreadCount());
+    if (ranges <= 1) {
+        if (count > 0) {
+            body(0, count);
+        }
+        return;
+    }
+
+    size_t per_range = count / ranges;
+    size_t remainder = count % ranges;
+    size_t begin = per_range + (remainder > 0 ? 1 : 0);
+    size_t first_end = begin;
+
+    {
+        std::lock_guard<std::mutex> lock(this->mutex);
+        for (size_t i = 1; i < ranges; i += 1) {
+            size_t end = begin + per_range + (i < remainder ? 1 : 0);
+            this->jobs.push_back([&body, begin, end]() { body(begin, end); });
+            begin = end;
+        }
+        this->pending += ranges - 1;
+    }
+    this->job_ready.notify_all();
+
+    body(0, first_end);
+
+    std::unique_lock<std::mutex> lock(this->mutex);
+    this->jobs_done.wait(lock, [this]() { return this->pending == 0; });
+}
+
+unsigned int ThreadPool::getThreadCount() {
+    return this->workers.size() + 1;
+}
+
+void ThreadPool::work() {
+    while (true) {
+        std::function<void()> job;
+        {
+            std::unique_lock<std::mutex> lock(this->mutex);
+            this->job_ready.wait(lock, [this]() { return this->stopping || !this->jobs.empty(); });
+            if (this->stopping && this->jobs.empty()) {
+                return;
+            }
+            job = std::move(this->jobs.front());
+            this->jobs.pop_front();
+        }
+
+        job();
+
+        bool finished;
+        {
+            std::lock_guard<std::mutex> lock(this->mutex);
+            this->pending -= 1;
+            finished = this->pending == 0;
+        }
+        if (finished) {
+            this->jobs_done.notify_all();
+        }
+    }
+}
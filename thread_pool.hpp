@@ -0,0 +1,30 @@
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+
+#ifndef THREAD_POOL_H
+#define THREAD_POOL_H
+
+// Fixed set of worker threads for splitting a loop into one contiguous range per thread.
+// The calling thread works on the first range itself, so a pool of 1 thread runs everything inline.
+class ThreadPool {
+public:
+    ThreadPool(unsigned int threads = 0); // 0 uses every hardware thread
+    ~ThreadPool();
+    void parallel_for(size_t count, const std::function<void(size_t begin, size_t end)>& body);
+    unsigned int getThreadCount();
+private:
+    void work();
+    std::vector<std::thread> workers;
+    std::deque<std::function<void()>> jobs;
+    std::mutex mutex;
+    std::condition_variable job_ready;
+    std::condition_variable jobs_done;
+    size_t pending = 0;
+    bool stopping = false;
+};
+
+#endif
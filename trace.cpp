@@ -0,0 +1,89 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <iomanip>
+
+#include "trace.hpp"
+
+// One per thread that ever recorded a zone. Owned by the registry rather than the thread, so the
+// events of pool workers that have already exited can still be written.
+struct TraceBuffer {
+    unsigned int thread_id;
+    std::vector<TraceEvent> events;
+};
+
+static std::mutex registry_mutex;
+static std::vector<TraceBuffer*> registry;
+static const auto trace_start = std::chrono::steady_clock::now();
+
+static int64_t now_ns() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - trace_start).count();
+}
+
+// Only a thread's first zone takes the registry lock
+static TraceBuffer& thread_buffer() {
+    thread_local TraceBuffer* buffer = nullptr;
+    if (buffer == nullptr) {
+        std::lock_guard<std::mutex> lock(registry_mutex);
+        buffer = new TraceBuffer();
+        buffer->thread_id = registry.size();
+        buffer->events.reserve(4096);
+        registry.push_back(buffer);
+    }
+    return *buffer;
+}
+
+// Registering on entry rather than exit numbers threads in the order they open their first zone
+TraceZone::TraceZone(const char* name) {
+    thread_buffer();
+    this->name = name;
+    this->start_ns = now_ns();
+}
+
+TraceZone::~TraceZone() {
+    TraceEvent event = {this->name, this->start_ns, now_ns() - this->start_ns};
+    thread_buffer().events.push_back(event);
+}
+
+bool write_trace(const std::string& path) {
+    if (!trace_enabled()) {
+        std::cout << "Tracing is compiled out; rebuild with -DFRAGMENT_TRACE=ON to record " << path << std::endl;
+        return false;
+    }
+
+    std::ofstream file(path);
+    if (!file) {
+        std::cout << "Failed to open " << path << " for writing" << std::endl;
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(registry_mutex);
+    size_t count = 0;
+    file << std::fixed << std::setprecision(3);
+    file << "{\"traceEvents\":[\n";
+    for (TraceBuffer* buffer : registry) {
+        file << (count++ > 0 ? ",\n" : "") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->thread_id
+             << ",\"args\":{\"name\":\"" << (buffer->thread_id == 0 ? "main" : "thread " + std::to_string(buffer->thread_id)) << "\"}}";
+
+        // Chrome trace timestamps are in microseconds
+        for (const TraceEvent& event : buffer->events) {
+            file << ",\n{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->thread_id
+                 << ",\"ts\":" << event.start_ns / 1000.0 << ",\"dur\":" << event.duration_ns / 1000.0 << "}";
+            count += 1;
+        }
+    }
+    file << "\n]}\n";
+
+    std::cout << "Wrote " << count << " trace events to " << path << std::endl;
+    return true;
+}
+
+bool trace_enabled() {
+#ifdef FRAGMENT_TRACE
+    return true;
+#else
+    return false;
+#endif
+}
@@ -0,0 +1,38 @@
+#include <string>
+#include <cstdint>
+
+#ifndef TRACE_H
+#define TRACE_H
+
+// TRACE_ZONE("name") times the rest of the enclosing scope. Zones only exist when built with FRAGMENT_TRACE;
+// otherwise the macro expands to nothing. Names must be string literals, they are stored by pointer.
+#ifdef FRAGMENT_TRACE
+    #define TRACE_CONCAT_INNER(a, b) a##b
+    #define TRACE_CONCAT(a, b) TRACE_CONCAT_INNER(a, b)
+    #define TRACE_ZONE(name) TraceZone TRACE_CONCAT(trace_zone_, __LINE__)(name)
+#else
+    #define TRACE_ZONE(name)
+#endif
+
+struct TraceEvent {
+    const char* name;
+    int64_t start_ns;
+    int64_t duration_ns;
+};
+
+// Appends to the calling thread's own buffer, so recording never takes a lock
+class TraceZone {
+public:
+    TraceZone(const char* name);
+    ~TraceZone();
+private:
+    const char* name;
+    int64_t start_ns;
+};
+
+// Writes every thread's zones as Chrome trace JSON (chrome://tracing, ui.perfetto.dev).
+// Call once the other threads have stopped recording.
+bool write_trace(const std::string& path);
+bool trace_enabled();
+
+#endif
@@ -1,3 +1,5 @@
+#include <cstdint>
+
 #ifndef VERTEX_H
 #define VERTEX_H
 
@@ -7,4 +9,21 @@ struct Vertex {
     nx, ny, nz; // Normal coordinates
 };
 
+// Quantized Vertex, 16 bytes instead of 36, read through normalized/integer attribute formats.
+// The position counts steps from the chunk origin; basic.vs scales and offsets it back through the
+// instance origin and size attributes, which hold the chunk's origin and step size for these meshes.
+struct PackedVertex {
+    int16_t x, y, z, // Steps from the chunk origin
+    w; // Padding, keeps the color 4-byte aligned
+    uint8_t r, g, b, a; // Color, unsigned normalized
+    uint32_t normal; // Signed normalized GL_INT_2_10_10_10_REV, x in the low bits
+};
+
+// Per-box record for instanced drawing of a unit cube
+struct Instance {
+    float x, y, z, // Origin
+    sx, sy, sz, // Size
+    r, g, b; // Color
+};
+
 #endif
\ No newline at end of file
@@ -0,0 +1,250 @@
+#include "voxels.hpp"
+
+// Rounds toward negative infinity, so cell -1 lands in brick -1 rather than brick 0
+static int floor_div(int value, int divisor) {
+    return value >= 0 ? value / divisor : -((-value + divisor - 1) / divisor);
+}
+
+// The brick holding a cell, along one axis
+int brick_coordinate(int cell) {
+    return floor_div(cell, BRICK_SIZE);
+}
+
+// Hash key of a cell or brick; 21 bits per axis
+long long grid_key(int x, int y, int z) {
+    return ((long long)(x & 0x1FFFFF) << 42) | ((long long)(y & 0x1FFFFF) << 21) | (z & 0x1FFFFF);
+}
+
+static bool same_color(const Color& a, const Color& b) {
+    return a.r == b.r && a.g == b.g && a.b == b.b;
+}
+
+// Returns false if the cell is already taken
+bool VoxelStore::add(int x, int y, int z, Color color) {
+    int bx = floor_div(x, BRICK_SIZE);
+    int by = floor_div(y, BRICK_SIZE);
+    int bz = floor_div(z, BRICK_SIZE);
+    int cell = (x - bx * BRICK_SIZE) + BRICK_SIZE * ((y - by * BRICK_SIZE) + BRICK_SIZE * (z - bz * BRICK_SIZE));
+
+    auto found = this->bricks.find(grid_key(bx, by, bz));
+    if (found == this->bricks.end()) {
+        glm::ivec3 brick = glm::ivec3(bx, by, bz);
+        this->brick_min = this->bricks.empty() ? brick : glm::min(this->brick_min, brick);
+        this->brick_max = this->bricks.empty() ? brick : glm::max(this->brick_max, brick);
+        found = this->bricks.emplace(grid_key(bx, by, bz), Brick()).first;
+    }
+    Brick& brick = found->second;
+
+    uint64_t bit = 1ULL << (cell % 64);
+    if (brick.occupied[cell / 64] & bit) {
+        return false;
+    }
+
+    // Builds tend to reuse a few colors, so the most recent palette entries are checked first
+    int index = brick.palette.size() - 1;
+    while (index >= 0 && !same_color(brick.palette[index], color)) {
+        index -= 1;
+    }
+    if (index < 0) {
+        index = brick.palette.size();
+        brick.palette.push_back(color);
+    }
+
+    glm::ivec3 local = glm::ivec3(x - bx * BRICK_SIZE, y - by * BRICK_SIZE, z - bz * BRICK_SIZE);
+    brick.low = brick.count == 0 ? local : glm::min(brick.low, local);
+    brick.high = brick.count == 0 ? local : glm::max(brick.high, local);
+    brick.occupied[cell / 64] |= bit;
+    brick.colors[cell] = index;
+    brick.count += 1;
+    this->count += 1;
+    return true;
+}
+
+// Returns false if the cell is empty. A brick's palette is compacted once most of its entries are unused.
+bool VoxelStore::remove(int x, int y, int z) {
+    int bx = floor_div(x, BRICK_SIZE);
+    int by = floor_div(y, BRICK_SIZE);
+    int bz = floor_div(z, BRICK_SIZE);
+    auto found = this->bricks.find(grid_key(bx, by, bz));
+    if (found == this->bricks.end()) {
+        return false;
+    }
+    Brick& brick = found->second;
+
+    int cell = (x - bx * BRICK_SIZE) + BRICK_SIZE * ((y - by * BRICK_SIZE) + BRICK_SIZE * (z - bz * BRICK_SIZE));
+    uint64_t bit = 1ULL << (cell % 64);
+    if (!(brick.occupied[cell / 64] & bit)) {
+        return false;
+    }
+
+    brick.occupied[cell / 64] &= ~bit;
+    brick.count -= 1;
+    this->count -= 1;
+
+    if (brick.count == 0) {
+        this->bricks.erase(found);
+    } else if (brick.palette.size() > 16 && brick.palette.size() > 2 * (size_t)brick.count) {
+        compact_palette(brick);
+    }
+    return true;
+}
+
+// Drops palette entries no occupied cell refers to and renumbers the cells
+void VoxelStore::compact_palette(Brick& brick) {
+    std::vector<int> remap(brick.palette.size(), -1);
+    std::vector<Color> palette;
+    for (int cell = 0; cell < BRICK_VOLUME; cell += 1) {
+        if (!(brick.occupied[cell / 64] >> (cell % 64) & 1)) {
+            continue;
+        }
+        int& index = remap[brick.colors[cell]];
+        if (index < 0) {
+            index = palette.size();
+            palette.push_back(brick.palette[brick.colors[cell]]);
+        }
+        brick.colors[cell] = index;
+    }
+    brick.palette.swap(palette);
+}
+
+bool VoxelStore::has(int x, int y, int z) const {
+    int cell;
+    const Brick* brick = this->find(x, y, z, cell);
+    return brick != nullptr && (brick->occupied[cell / 64] >> (cell % 64) & 1);
+}
+
+bool VoxelStore::getColor(int x, int y, int z, Color& color) const {
+    int cell;
+    const Brick* brick = this->find(x, y, z, cell);
+    if (brick == nullptr || !(brick->occupied[cell / 64] >> (cell % 64) & 1)) {
+        return false;
+    }
+    color = brick->palette[brick->colors[cell]];
+    return true;
+}
+
+// Appends every block in brick bx, by, bz
+void VoxelStore::collect_brick(int bx, int by, int bz, std::vector<Block>& blocks) const {
+    auto found = this->bricks.find(grid_key(bx, by, bz));
+    if (found == this->bricks.end()) {
+        return;
+    }
+
+    const Brick& brick = found->second;
+    for (int word = 0; word < BRICK_VOLUME / 64; word += 1) {
+        uint64_t bits = brick.occupied[word];
+        for (int bit = 0; bits != 0 && bit < 64; bit += 1) {
+            if (!(bits >> bit & 1)) {
+                continue;
+            }
+
+            int cell = word * 64 + bit;
+            Block block;
+            block.x = bx * BRICK_SIZE + cell % BRICK_SIZE;
+            block.y = by * BRICK_SIZE + cell / BRICK_SIZE % BRICK_SIZE;
+            block.z = bz * BRICK_SIZE + cell / (BRICK_SIZE * BRICK_SIZE);
+            block.color = brick.palette[brick.colors[cell]];
+            blocks.push_back(block);
+        }
+    }
+}
+
+// The size-wide cell the ray is in at distance, kept within the count cells from lo against rounding
+static glm::ivec3 entry_cell(const glm::vec3& origin, const glm::vec3& direction, float distance, float size, const glm::ivec3& lo, int count) {
+    return glm::clamp(grid_cell(origin + direction * distance, size), lo, lo + (count - 1));
+}
+
+// Whether the walk's last step kept it within the count cells from lo; only the stepped axis can have left
+static bool stays_within(const GridWalk& walk, const glm::ivec3& lo, int count) {
+    int offset = walk.cell[walk.axis] - lo[walk.axis];
+    return offset >= 0 && offset < count;
+}
+
+// Two-level DDA over the part of the ray inside the bricks' extent: the walk over bricks skips empty ones with a single
+// lookup each, and inside an allocated brick a walk over the cells of its blocks' box tests occupancy bits directly.
+// direction should be unit length for distances in world units.
+bool VoxelStore::raycast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, RayHit& hit) const {
+    if (this->bricks.empty()) {
+        return false;
+    }
+
+    float enter, leave;
+    int axis;
+    glm::vec3 inverse_direction = 1.0f / direction;
+    Bounds extent = {glm::vec3(this->brick_min * BRICK_SIZE), glm::vec3((this->brick_max + 1) * BRICK_SIZE)};
+    if (!clip_ray(extent, origin, inverse_direction, max_distance, enter, leave, axis)) {
+        return false;
+    }
+
+    glm::ivec3 first = glm::clamp(grid_cell(origin + direction * enter, BRICK_SIZE), this->brick_min, this->brick_max);
+    GridWalk bricks = GridWalk(origin, inverse_direction, BRICK_SIZE, first, enter);
+    bricks.axis = axis;
+    for (; bricks.distance <= leave; bricks.advance()) {
+        auto found = this->bricks.find(grid_key(bricks.cell[0], bricks.cell[1], bricks.cell[2]));
+        if (found == this->bricks.end()) {
+            continue;
+        }
+
+        // Skip the brick unless the ray crosses the box its blocks lie in, and start stepping cells where it enters that box
+        const Brick& brick = found->second;
+        glm::ivec3 lo = glm::ivec3(bricks.cell[0], bricks.cell[1], bricks.cell[2]) * BRICK_SIZE;
+        Bounds occupied = {glm::vec3(lo + brick.low), glm::vec3(lo + brick.high + 1)};
+        float start, end;
+        int start_axis;
+        if (!clip_ray(occupied, origin, inverse_direction, max_distance, start, end, start_axis)) {
+            continue;
+        }
+        if (start <= bricks.distance) {
+            start = bricks.distance;
+            start_axis = bricks.axis;
+        }
+
+        GridWalk cells = GridWalk(origin, inverse_direction, 1.0f, entry_cell(origin, direction, start, 1.0f, lo, BRICK_SIZE), start);
+        cells.axis = start_axis;
+        do {
+            int cell = (cells.cell[0] - lo.x) + BRICK_SIZE * ((cells.cell[1] - lo.y) + BRICK_SIZE * (cells.cell[2] - lo.z));
+            if (brick.occupied[cell / 64] >> (cell % 64) & 1) {
+                hit.distance = cells.distance;
+                hit.point = origin + direction * cells.distance;
+                hit.cell = glm::ivec3(cells.cell[0], cells.cell[1], cells.cell[2]);
+                hit.normal = glm::ivec3(0);
+                if (cells.axis >= 0) {
+                    hit.normal[cells.axis] = -cells.step[cells.axis];
+                }
+                hit.block = true;
+                return true;
+            }
+            cells.advance();
+        } while (cells.distance <= end && stays_within(cells, lo, BRICK_SIZE));
+    }
+    return false;
+}
+
+const Brick* VoxelStore::find(int x, int y, int z, int& cell) const {
+    int bx = floor_div(x, BRICK_SIZE);
+    int by = floor_div(y, BRICK_SIZE);
+    int bz = floor_div(z, BRICK_SIZE);
+    auto found = this->bricks.find(grid_key(bx, by, bz));
+    if (found == this->bricks.end()) {
+        return nullptr;
+    }
+    cell = (x - bx * BRICK_SIZE) + BRICK_SIZE * ((y - by * BRICK_SIZE) + BRICK_SIZE * (z - bz * BRICK_SIZE));
+    return &found->second;
+}
+
+size_t VoxelStore::getCount() const {
+    return this->count;
+}
+
+size_t VoxelStore::getBrickCount() const {
+    return this->bricks.size();
+}
+
+// Brick storage and palettes; the hash maps' own bookkeeping is not counted
+size_t VoxelStore::getBytes() const {
+    size_t bytes = 0;
+    for (auto& entry : this->bricks) {
+        bytes += sizeof(Brick) + entry.second.colors.capacity() * sizeof(uint16_t) + entry.second.palette.capacity() * sizeof(Color);
+    }
+    return bytes;
+}
@@ -0,0 +1,51 @@
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "cube.hpp"
+#include "greedy.hpp"
+#include "raycast.hpp"
+
+#ifndef VOXELS_H
+#define VOXELS_H
+
+// Bricks are BRICK_SIZE^3 cells of the block grid
+const int BRICK_SIZE = 16;
+const int BRICK_VOLUME = BRICK_SIZE * BRICK_SIZE * BRICK_SIZE;
+
+int brick_coordinate(int cell);
+long long grid_key(int x, int y, int z);
+
+// Dense storage for one brick: an occupancy bit per cell and, where set, an index into the brick's own palette.
+// Removal compacts a palette before it outgrows twice the brick's block count, so 16-bit indices always suffice.
+// The indices live in their own allocation, keeping the bricks in the map small for raycasts that only read occupancy.
+struct Brick {
+    glm::ivec3 low, high; // brick-local cells every block lies within, for raycasts; removal does not shrink them
+    uint64_t occupied[BRICK_VOLUME / 64] = {};
+    std::vector<uint16_t> colors = std::vector<uint16_t>(BRICK_VOLUME);
+    std::vector<Color> palette;
+    int count = 0;
+};
+
+// The authoritative set of placed blocks. Bricks live in a hash map, allocated when the first block lands in them
+// and freed with their last one, so memory follows the occupied part of the grid rather than the blocks' vertex count.
+// Occupancy and color queries are a hash lookup plus a bit test.
+class VoxelStore {
+public:
+    bool add(int x, int y, int z, Color color);
+    bool remove(int x, int y, int z);
+    bool has(int x, int y, int z) const;
+    bool getColor(int x, int y, int z, Color& color) const;
+    void collect_brick(int bx, int by, int bz, std::vector<Block>& blocks) const;
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, RayHit& hit) const;
+    size_t getCount() const;
+    size_t getBrickCount() const;
+    size_t getBytes() const;
+private:
+    const Brick* find(int x, int y, int z, int& cell) const;
+    void compact_palette(Brick& brick);
+    std::unordered_map<long long, Brick> bricks;
+    glm::ivec3 brick_min = glm::ivec3(0), brick_max = glm::ivec3(0); // every brick allocated so far lies within these, a ray's first test
+    size_t count = 0;
+};
+
+#endif
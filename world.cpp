@@ -0,0 +1,739 @@
+#include <cmath>
+#include <algorithm>
+#ifdef __APPLE__
+    #include <OpenGL/gl3.h>
+#else
+    #include <OpenGL/gl.h>
+#endif
+
+#include "world.hpp"
+#include "trace.hpp"
+
+static glm::vec3 chunk_origin(const Chunk& chunk) {
+    return glm::vec3(chunk.x * CHUNK_SIZE, 0.0f, chunk.z * CHUNK_SIZE);
+}
+
+// The six cells sharing a face with a block
+static const int NEIGHBOURS[6][3] = {{0, 0, 1}, {0, 0, -1}, {0, 1, 0}, {0, -1, 0}, {-1, 0, 0}, {1, 0, 0}};
+
+void World::set_geometry_mode(GeometryMode mode) {
+    this->mode = mode;
+}
+
+void World::set_streaming(bool streaming) {
+    this->streaming = streaming;
+}
+
+void World::set_culling(bool culling) {
+    this->culling = culling;
+}
+
+// Hierarchical-Z occlusion culling on top of frustum culling, its depth buffer rendered on pool; null turns it off
+void World::set_occlusion(ThreadPool* pool) {
+    this->occlusion_pool = pool;
+}
+
+// Box geometry in arrays and indexed modes and every block mesh; instanced boxes have no per-vertex data to pack
+void World::set_packed_vertices(bool packed) {
+    this->packed = packed;
+}
+
+void World::add_box(CubeSize size, Origin origin, Color color) {
+    Instance box = {origin.x, origin.y, origin.z, size.x, size.y, size.z, color.r, color.g, color.b};
+    Chunk& chunk = this->insert_box(box);
+    this->box_tree.insert(chunk.box_bounds.get(chunk.box_bounds.size() - 1));
+    this->append_geometry(chunk, chunk.boxes.size() - 1);
+}
+
+// Unit block filling grid cell [x, x + 1) x [y, y + 1) x [z, z + 1), stored in the voxel store. Its brick is greedy-meshed
+// again on the next upload, together with any neighbouring brick whose blocks lose a face to this one.
+// Returns false if the cell is taken.
+bool World::add_block(int x, int y, int z, Color color) {
+    if (!this->voxels.add(x, y, z, color)) {
+        return false;
+    }
+
+    // FNV-1a over the block's cell and color, continuing the checksum of the boxes
+    int cell[] = {x, y, z};
+    const unsigned char* bytes[] = {(const unsigned char*)cell, (const unsigned char*)&color};
+    size_t sizes[] = {sizeof(cell), sizeof(color)};
+    for (int part = 0; part < 2; part += 1) {
+        for (size_t i = 0; i < sizes[part]; i += 1) {
+            this->checksum = (this->checksum ^ bytes[part][i]) * 1099511628211ULL;
+        }
+    }
+
+    Bounds bounds;
+    bounds.min = glm::vec3(x, y, z);
+    bounds.max = glm::vec3(x + 1, y + 1, z + 1);
+    Chunk& chunk = this->chunk_at(x + 0.5f, z + 0.5f);
+    this->grow_bounds(chunk, bounds);
+    chunk.block_count += 1;
+    this->check_steps(chunk);
+    this->remesh_brick(x, y, z);
+    this->remesh_neighbours(x, y, z);
+    return true;
+}
+
+// Empties the cell; its brick and any neighbouring brick with a block against it are remeshed on the next upload.
+// The chunk's bounds are left as they are, they only have to be conservative. Returns false if the cell was empty.
+bool World::remove_block(int x, int y, int z) {
+    if (!this->voxels.remove(x, y, z)) {
+        return false;
+    }
+
+    Chunk& chunk = this->chunk_at(x + 0.5f, z + 0.5f);
+    chunk.block_count -= 1;
+    this->remesh_brick(x, y, z);
+    this->remesh_neighbours(x, y, z);
+    return true;
+}
+
+// Queues the brick holding cell x, y, z for meshing on its chunk's next upload
+void World::remesh_brick(int x, int y, int z) {
+    Chunk& chunk = this->chunk_at(x + 0.5f, z + 0.5f);
+    glm::ivec3 brick(brick_coordinate(x), brick_coordinate(y), brick_coordinate(z));
+    if (std::find(chunk.remesh_bricks.begin(), chunk.remesh_bricks.end(), brick) == chunk.remesh_bricks.end()) {
+        chunk.remesh_bricks.push_back(brick);
+    }
+    chunk.remesh = true;
+    this->mark_dirty(chunk);
+}
+
+// A block changing at x, y, z changes which faces of the blocks beside it are exposed. Inside its own brick that is
+// covered already; across a brick border the neighbouring brick needs meshing too.
+void World::remesh_neighbours(int x, int y, int z) {
+    for (int i = 0; i < 6; i += 1) {
+        int nx = x + NEIGHBOURS[i][0];
+        int ny = y + NEIGHBOURS[i][1];
+        int nz = z + NEIGHBOURS[i][2];
+        bool other_brick = brick_coordinate(nx) != brick_coordinate(x) || brick_coordinate(ny) != brick_coordinate(y) || brick_coordinate(nz) != brick_coordinate(z);
+        if (other_brick && this->hasBlock(nx, ny, nz)) {
+            this->remesh_brick(nx, ny, nz);
+        }
+    }
+}
+
+bool World::hasBlock(int x, int y, int z) {
+    return this->voxels.has(x, y, z);
+}
+
+const VoxelStore& World::getVoxels() {
+    return this->voxels;
+}
+
+// Nearest block or box along the ray within max_distance; direction should be unit length.
+// Blocks win ties, so a block placed flush against a building is the one picked.
+bool World::raycast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, RayHit& hit) {
+    TRACE_ZONE("World::raycast");
+    bool found = this->voxels.raycast(origin, direction, max_distance, hit);
+    RayHit box_hit;
+    uint32_t box;
+    if (this->box_tree.raycast(origin, direction, found ? hit.distance : max_distance, box_hit, box) && (!found || box_hit.distance < hit.distance)) {
+        hit = box_hit;
+        found = true;
+    }
+    return found;
+}
+
+// How far body gets along movement through the boxes and blocks, sliding along any it runs into (see sweep()).
+// The box tree's overlap query finds the buildings near the move, which costs about the log of the box count, and
+// only the block cells the move passes through are looked up, so the rest depends on how far the body moves.
+glm::vec3 World::move(const Bounds& body, const glm::vec3& movement) {
+    TRACE_ZONE("World::move");
+    Bounds swept;
+    swept.min = glm::min(body.min, body.min + movement);
+    swept.max = glm::max(body.max, body.max + movement);
+    this->nearby_boxes.clear();
+    this->box_tree.overlap(swept, this->nearby_boxes);
+    this->obstacles.clear();
+    for (uint32_t box : this->nearby_boxes) {
+        this->obstacles.push_back(this->box_tree.getBounds(box));
+    }
+
+    glm::ivec3 low = grid_cell(swept.min, 1.0f);
+    glm::ivec3 high = grid_cell(swept.max, 1.0f);
+    for (int x = low.x; x <= high.x; x += 1) {
+        for (int y = low.y; y <= high.y; y += 1) {
+            for (int z = low.z; z <= high.z; z += 1) {
+                if (this->voxels.has(x, y, z)) {
+                    this->obstacles.push_back({glm::vec3(x, y, z), glm::vec3(x + 1, y + 1, z + 1)});
+                }
+            }
+        }
+    }
+    return sweep(body, movement, this->obstacles);
+}
+
+// Same result as calling add_box for each box in order. Boxes are sorted into chunks on this thread,
+// then every touched chunk meshes its new boxes on the pool into storage sized once up front.
+void World::add_boxes(const std::vector<Instance>& boxes, ThreadPool& pool) {
+    TRACE_ZONE("World::add_boxes");
+    std::unordered_map<Chunk*, size_t> first_new;
+    std::vector<Chunk*> touched;
+    std::vector<Bounds> added;
+    for (const Instance& box : boxes) {
+        Chunk* chunk = &this->chunk_at(box.x, box.z);
+        if (first_new.find(chunk) == first_new.end()) {
+            first_new[chunk] = chunk->boxes.size();
+            touched.push_back(chunk);
+        }
+        this->insert_box(box);
+        added.push_back(chunk->box_bounds.get(chunk->box_bounds.size() - 1));
+    }
+    this->box_tree.insert(added);
+
+    std::vector<size_t> first_boxes;
+    for (Chunk* chunk : touched) {
+        first_boxes.push_back(first_new[chunk]);
+    }
+
+    pool.parallel_for(touched.size(), [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i += 1) {
+            this->append_geometry(*touched[i], first_boxes[i]);
+        }
+    });
+}
+
+// Files the box under its chunk without generating geometry
+Chunk& World::insert_box(const Instance& box) {
+    Bounds bounds;
+    bounds.min = glm::vec3(box.x - box.sx / 2, box.y - box.sy / 2, box.z - box.sz / 2);
+    bounds.max = glm::vec3(box.x + box.sx / 2, box.y + box.sy / 2, box.z + box.sz / 2);
+
+    Chunk& chunk = this->chunk_at(box.x, box.z);
+    this->grow_bounds(chunk, bounds);
+    chunk.boxes.push_back(box);
+    chunk.box_bounds.push_back(bounds);
+
+    // FNV-1a over every box in the order added, to confirm two runs built byte-identical worlds
+    const unsigned char* bytes = (const unsigned char*)&box;
+    for (size_t i = 0; i < sizeof(Instance); i += 1) {
+        this->checksum = (this->checksum ^ bytes[i]) * 1099511628211ULL;
+    }
+
+    this->mark_dirty(chunk);
+    return chunk;
+}
+
+void World::grow_bounds(Chunk& chunk, const Bounds& bounds) {
+    if (chunk.boxes.empty() && chunk.block_count == 0) {
+        chunk.bounds = bounds;
+    } else {
+        chunk.bounds.min = glm::min(chunk.bounds.min, bounds.min);
+        chunk.bounds.max = glm::max(chunk.bounds.max, bounds.max);
+    }
+}
+
+void World::mark_dirty(Chunk& chunk) {
+    if (!chunk.dirty) {
+        chunk.dirty = true;
+        this->dirty_chunks.push_back(&chunk);
+    }
+}
+
+// Bring every edited chunk's GPU mesh up to date
+void World::upload() {
+    TRACE_ZONE("World::upload");
+    if (this->mode == INSTANCED && this->unit_cube.getVAO() == 0) {
+        // Unit cube centered on the origin, scaled, moved and tinted per instance in basic.vs
+        CubeSize size = {1.0f, 1.0f, 1.0f};
+        Origin origin = {0.0f, 0.0f, 0.0f};
+        Color color = {1.0f, 1.0f, 1.0f};
+        this->unit_cube.bind_buffers(create_indexed_cube(size, origin, color), create_cube_indices(0));
+    }
+
+    for (Chunk* chunk : this->dirty_chunks) {
+        this->upload_chunk(*chunk);
+    }
+    this->dirty_chunks.clear();
+}
+
+// Chunks outside the frustum are skipped outright. Inside a visible chunk every box is tested and runs of
+// visible boxes are merged into one range each for glMultiDraw*. Instanced chunks are culled as a whole.
+// A chunk's blocks are one more draw of its block mesh.
+void World::draw(const Frustum& frustum, const glm::mat4& view_projection, const glm::vec3& eye) {
+    TRACE_ZONE("World::draw");
+    this->stats = {};
+    bool occlusion = this->culling && this->occlusion_pool != nullptr;
+    if (occlusion) {
+        this->render_occluders(frustum, view_projection, eye);
+    }
+
+    for (auto& entry : this->chunks) {
+        Chunk& chunk = entry.second;
+        if (chunk.boxes.empty() && chunk.block_quads == 0) {
+            continue;
+        }
+
+        if (this->culling && !frustum.intersects(chunk.bounds)) {
+            this->stats.culled_chunks += 1;
+            this->stats.culled_boxes += chunk.boxes.size();
+            continue;
+        }
+        if (occlusion && !this->occlusion.visible(chunk.bounds)) {
+            this->stats.occluded_chunks += 1;
+            this->stats.occluded_boxes += chunk.boxes.size();
+            continue;
+        }
+
+        this->stats.drawn_chunks += 1;
+        if (!chunk.boxes.empty()) {
+            this->draw_boxes(chunk, frustum, occlusion);
+        }
+
+        if (chunk.block_quads > 0 && (!this->culling || frustum.intersects(chunk.block_bounds)) && (!occlusion || this->occlusion.visible(chunk.block_bounds))) {
+            this->stats.draw_calls += 1;
+            this->stats.drawn_vertices += chunk.block_quads * 6;
+            this->set_mesh_transform(chunk);
+            glBindVertexArray(chunk.block_mesh.getVAO());
+            if (this->mode == INDEXED) {
+                glDrawElements(GL_TRIANGLES, chunk.block_quads * 6, GL_UNSIGNED_INT, 0);
+            } else {
+                glDrawArrays(GL_TRIANGLES, 0, chunk.block_quads * 6);
+            }
+        }
+    }
+
+    // Back to the identity transform every other mesh expects
+    glVertexAttrib3f(3, 0.0f, 0.0f, 0.0f);
+    glVertexAttrib3f(4, 1.0f, 1.0f, 1.0f);
+    glVertexAttrib3f(5, 1.0f, 1.0f, 1.0f);
+}
+
+// Distance from point to the nearest point of bounds, zero inside
+static float distance_to(const Bounds& bounds, const glm::vec3& point) {
+    return glm::length(glm::max(glm::max(bounds.min - point, point - bounds.max), glm::vec3(0.0f)));
+}
+
+// Occluders are the big boxes in view from the chunks nearest the eye, the nearest OCCLUDER_COUNT of them.
+// Thin or small boxes such as the ground and blocks hide little and are left out.
+void World::render_occluders(const Frustum& frustum, const glm::mat4& view_projection, const glm::vec3& eye) {
+    TRACE_ZONE("World::render_occluders");
+    this->nearest_chunks.clear();
+    for (const auto& entry : this->chunks) {
+        const Chunk& chunk = entry.second;
+        if (!chunk.boxes.empty() && frustum.intersects(chunk.bounds)) {
+            this->nearest_chunks.push_back({distance_to(chunk.bounds, eye), &chunk});
+        }
+    }
+    std::sort(this->nearest_chunks.begin(), this->nearest_chunks.end());
+
+    // Chunks overlap, so a box in the next chunk can still be nearer than one already taken; stop a chunk later
+    this->occluders.clear();
+    size_t end = this->nearest_chunks.size();
+    for (size_t i = 0; i < end; i += 1) {
+        const Chunk& chunk = *this->nearest_chunks[i].second;
+        for (size_t box = 0; box < chunk.box_bounds.size(); box += 1) {
+            Bounds bounds = chunk.box_bounds.get(box);
+            glm::vec3 size = bounds.max - bounds.min;
+            if (std::min(size.x, std::min(size.y, size.z)) >= OCCLUDER_MIN_SIZE && frustum.intersects(bounds)) {
+                this->occluders.push_back(bounds);
+            }
+        }
+        if (this->occluders.size() >= OCCLUDER_COUNT) {
+            end = std::min(end, i + 2);
+        }
+    }
+    if (this->occluders.size() > OCCLUDER_COUNT) {
+        std::nth_element(this->occluders.begin(), this->occluders.begin() + OCCLUDER_COUNT, this->occluders.end(), [&](const Bounds& a, const Bounds& b) {
+            return distance_to(a, eye) < distance_to(b, eye);
+        });
+        this->occluders.resize(OCCLUDER_COUNT);
+    }
+
+    this->occlusion.render(view_projection, eye, this->occluders, *this->occlusion_pool);
+    this->stats.occluders = this->occluders.size();
+}
+
+void World::draw_boxes(Chunk& chunk, const Frustum& frustum, bool occlusion) {
+    this->stats.draw_calls += 1;
+    glBindVertexArray(chunk.mesh.getVAO());
+
+    if (this->mode == INSTANCED) {
+        this->stats.drawn_boxes += chunk.boxes.size();
+        this->stats.drawn_vertices += chunk.boxes.size() * 36;
+        glDrawElementsInstanced(GL_TRIANGLES, 36, GL_UNSIGNED_INT, 0, chunk.boxes.size());
+        return;
+    }
+
+    if (this->packed) {
+        this->set_mesh_transform(chunk);
+    }
+
+    this->visible.resize(chunk.boxes.size());
+    if (this->culling) {
+        frustum.test(chunk.box_bounds, this->visible.data());
+    } else {
+        std::fill(this->visible.begin(), this->visible.end(), 1);
+    }
+
+    // Every box owns 36 consecutive vertices (arrays) or indices (indexed) in the chunk's buffers
+    this->firsts.clear();
+    this->counts.clear();
+    for (size_t i = 0; i < chunk.boxes.size(); i += 1) {
+        if (!this->visible[i]) {
+            this->stats.culled_boxes += 1;
+            continue;
+        }
+        if (occlusion && !this->occlusion.visible(chunk.box_bounds.get(i))) {
+            this->stats.occluded_boxes += 1;
+            continue;
+        }
+
+        this->stats.drawn_boxes += 1;
+        this->stats.drawn_vertices += 36;
+        int first = i * 36;
+        if (!this->firsts.empty() && this->firsts.back() + this->counts.back() == first) {
+            this->counts.back() += 36;
+        } else {
+            this->firsts.push_back(first);
+            this->counts.push_back(36);
+        }
+    }
+
+    if (this->mode == INDEXED) {
+        this->offsets.clear();
+        for (int first : this->firsts) {
+            this->offsets.push_back((const void*)(first * sizeof(unsigned int)));
+        }
+        glMultiDrawElements(GL_TRIANGLES, this->counts.data(), GL_UNSIGNED_INT, this->offsets.data(), this->counts.size());
+    } else {
+        glMultiDrawArrays(GL_TRIANGLES, this->firsts.data(), this->counts.data(), this->counts.size());
+    }
+}
+
+// World-space meshes read the instance attributes as constants. Packed positions are steps from the chunk origin,
+// so for them the origin and size carry the dequantization: position = origin + steps * (1 / steps_per_unit).
+// Instanced draws leave these values undefined, hence the color too.
+void World::set_mesh_transform(const Chunk& chunk) {
+    glm::vec3 origin(0.0f);
+    float step = 1.0f;
+    if (this->packed) {
+        origin = chunk_origin(chunk);
+        step = 1.0f / chunk.steps_per_unit;
+    }
+    glVertexAttrib3f(3, origin.x, origin.y, origin.z);
+    glVertexAttrib3f(4, step, step, step);
+    glVertexAttrib3f(5, 1.0f, 1.0f, 1.0f);
+}
+
+// Call once per frame after the draw calls have been issued
+void World::end_frame() {
+    if (this->streaming) {
+        this->stream.fence();
+    }
+}
+
+Chunk& World::chunk_at(float x, float z) {
+    int chunk_x = (int)std::floor(x / CHUNK_SIZE);
+    int chunk_z = (int)std::floor(z / CHUNK_SIZE);
+    long long key = ((long long)chunk_x << 32) | (unsigned int)chunk_z;
+
+    auto found = this->chunks.find(key);
+    if (found != this->chunks.end()) {
+        return found->second;
+    }
+
+    Chunk& chunk = this->chunks[key];
+    chunk.x = chunk_x;
+    chunk.z = chunk_z;
+    return chunk;
+}
+
+// Finest power-of-two quantization whose int16 offsets from the chunk origin still reach every box in the chunk.
+// Boxes may overhang their chunk (the ground spans the whole world), so this comes from the bounds, not CHUNK_SIZE.
+static float packing_steps(const Chunk& chunk) {
+    glm::vec3 origin = chunk_origin(chunk);
+    float extent = 1.0f;
+    for (int axis = 0; axis < 3; axis += 1) {
+        extent = std::max(extent, std::fabs(chunk.bounds.min[axis] - origin[axis]));
+        extent = std::max(extent, std::fabs(chunk.bounds.max[axis] - origin[axis]));
+    }
+    return std::exp2(std::floor(std::log2(32767.0f / extent)));
+}
+
+static uint32_t pack_snorm10(float value) {
+    return (uint32_t)std::lround(std::min(std::max(value, -1.0f), 1.0f) * 511.0f) & 0x3FF;
+}
+
+static uint8_t pack_unorm8(float value) {
+    return (uint8_t)std::lround(std::min(std::max(value, 0.0f), 1.0f) * 255.0f);
+}
+
+static PackedVertex pack_vertex(const Vertex& vertex, const glm::vec3& origin, float steps) {
+    PackedVertex packed;
+    packed.x = (int16_t)std::lround((vertex.x - origin.x) * steps);
+    packed.y = (int16_t)std::lround((vertex.y - origin.y) * steps);
+    packed.z = (int16_t)std::lround((vertex.z - origin.z) * steps);
+    packed.w = 0;
+    packed.r = pack_unorm8(vertex.r);
+    packed.g = pack_unorm8(vertex.g);
+    packed.b = pack_unorm8(vertex.b);
+    packed.a = 255;
+    packed.normal = pack_snorm10(vertex.nx) | pack_snorm10(vertex.ny) << 10 | pack_snorm10(vertex.nz) << 20;
+    return packed;
+}
+
+// Packed vertices address the chunk in power-of-two steps from its origin. A box or block beyond what the current
+// step size can reach means requantizing the whole chunk on upload.
+void World::check_steps(Chunk& chunk) {
+    if (!this->packed) {
+        return;
+    }
+
+    float steps = packing_steps(chunk);
+    if (chunk.steps_per_unit == 0.0f) {
+        chunk.steps_per_unit = steps;
+    } else if (steps < chunk.steps_per_unit) {
+        chunk.rebuild = true;
+    }
+}
+
+// Generates geometry for chunk.boxes[first_box..]. Only the modes that bake boxes into world-space triangles
+// keep CPU vertices. Touches nothing but the chunk, so different chunks can be meshed on different threads.
+void World::append_geometry(Chunk& chunk, size_t first_box) {
+    TRACE_ZONE("World::append_geometry");
+    if (chunk.rebuild) {
+        return;
+    }
+
+    // Instanced chunks still track the step size, their block mesh is packed too
+    this->check_steps(chunk);
+    if (this->mode == INSTANCED || chunk.rebuild) {
+        return;
+    }
+
+    size_t count = chunk.boxes.size() - first_box;
+    size_t per_box = this->mode == INDEXED ? INDEXED_CUBE_VERTICES : CUBE_VERTICES;
+    size_t first_vertex = this->packed ? chunk.packed_vertices.size() : chunk.vertices.size();
+    size_t first_index = chunk.indices.size();
+
+    if (this->packed) {
+        chunk.packed_vertices.resize(first_vertex + count * per_box);
+    } else {
+        chunk.vertices.resize(first_vertex + count * per_box);
+    }
+    if (this->mode == INDEXED) {
+        chunk.indices.resize(first_index + count * CUBE_INDICES);
+    }
+
+    glm::vec3 origin_of_chunk = chunk_origin(chunk);
+    Vertex cube[CUBE_VERTICES];
+    for (size_t i = 0; i < count; i += 1) {
+        const Instance& box = chunk.boxes[first_box + i];
+        CubeSize size = {box.sx, box.sy, box.sz};
+        Origin origin = {box.x, box.y, box.z};
+        Color color = {box.r, box.g, box.b};
+
+        // Packed vertices are built as floats first and quantized below
+        size_t base = first_vertex + i * per_box;
+        Vertex* out = this->packed ? cube : &chunk.vertices[base];
+        if (this->mode == INDEXED) {
+            write_indexed_cube(size, origin, color, out);
+            write_cube_indices(base, &chunk.indices[first_index + i * CUBE_INDICES]);
+        } else {
+            write_cube(size, origin, color, out);
+        }
+
+        if (this->packed) {
+            for (size_t v = 0; v < per_box; v += 1) {
+                chunk.packed_vertices[base + v] = pack_vertex(cube[v], origin_of_chunk, chunk.steps_per_unit);
+            }
+        }
+    }
+}
+
+// Gives a vector's spare capacity back once it is mostly unused, like GrowableBuffer::assign does on the GPU
+template <typename T>
+static void shrink_if_sparse(std::vector<T>& vector) {
+    if (vector.size() < vector.capacity() / 4) {
+        vector.shrink_to_fit();
+    }
+}
+
+// Greedy-meshes the queued bricks from the voxel store, then rebuilds the chunk's block mesh from every brick's quads.
+// Quads never span bricks, so an edit costs one brick's meshing however many blocks the chunk holds.
+void World::mesh_blocks(Chunk& chunk) {
+    TRACE_ZONE("World::mesh_blocks");
+    for (const glm::ivec3& brick : chunk.remesh_bricks) {
+        this->mesher_blocks.clear();
+        this->voxels.collect_brick(brick.x, brick.y, brick.z, this->mesher_blocks);
+
+        long long key = grid_key(brick.x, brick.y, brick.z);
+        if (this->mesher_blocks.empty()) {
+            chunk.brick_quads.erase(key);
+            continue;
+        }
+
+        std::vector<Quad>& quads = chunk.brick_quads[key];
+        quads.clear();
+        greedy_mesh(this->mesher_blocks, [this](int x, int y, int z) { return this->hasBlock(x, y, z); }, quads);
+        shrink_if_sparse(quads);
+    }
+    chunk.remesh_bricks.clear();
+
+    size_t quads = 0;
+    for (auto& entry : chunk.brick_quads) {
+        quads += entry.second.size();
+    }
+
+    size_t per_quad = this->mode == INDEXED ? 4 : 6;
+    chunk.block_vertices.resize(quads * per_quad);
+    chunk.block_indices.resize(this->mode == INDEXED ? quads * 6 : 0);
+    size_t i = 0;
+    for (auto& entry : chunk.brick_quads) {
+        for (const Quad& quad : entry.second) {
+            if (this->mode == INDEXED) {
+                write_quad(quad, &chunk.block_vertices[i * 4]);
+                write_quad_indices(i * 4, 1, &chunk.block_indices[i * 6]);
+            } else {
+                write_quad_triangles(quad, &chunk.block_vertices[i * 6]);
+            }
+
+            if (i == 0) {
+                chunk.block_bounds.min = chunk.block_bounds.max = quad.corners[0];
+            }
+            chunk.block_bounds.min = glm::min(chunk.block_bounds.min, glm::min(quad.corners[0], quad.corners[3]));
+            chunk.block_bounds.max = glm::max(chunk.block_bounds.max, glm::max(quad.corners[0], quad.corners[3]));
+            i += 1;
+        }
+    }
+    chunk.block_quads = quads;
+
+    if (this->packed) {
+        glm::vec3 origin = chunk_origin(chunk);
+        chunk.packed_block_vertices.resize(chunk.block_vertices.size());
+        for (size_t i = 0; i < chunk.block_vertices.size(); i += 1) {
+            chunk.packed_block_vertices[i] = pack_vertex(chunk.block_vertices[i], origin, chunk.steps_per_unit);
+        }
+        chunk.block_vertices.clear();
+        chunk.block_mesh.bind_buffers(chunk.packed_block_vertices, chunk.block_indices);
+    } else {
+        chunk.block_mesh.bind_buffers(chunk.block_vertices, chunk.block_indices);
+    }
+
+    shrink_if_sparse(chunk.block_vertices);
+    shrink_if_sparse(chunk.packed_block_vertices);
+    shrink_if_sparse(chunk.block_indices);
+}
+
+// A chunk seen for the first time or flagged for rebuild is uploaded whole; otherwise only what was appended since
+void World::upload_chunk(Chunk& chunk) {
+    TRACE_ZONE("World::upload_chunk");
+    bool rebuild = chunk.rebuild;
+    if (rebuild) {
+        chunk.rebuild = false;
+        chunk.vertices.clear();
+        chunk.packed_vertices.clear();
+        chunk.indices.clear();
+        chunk.steps_per_unit = 0.0f;
+        this->append_geometry(chunk, 0);
+        if (this->packed && chunk.block_count > 0) {
+            chunk.remesh = true; // requantized with the rest of the chunk
+        }
+    }
+
+    // A chunk holding only blocks has no box mesh at all
+    bool boxes = !chunk.boxes.empty();
+    if (boxes && (rebuild || chunk.mesh.getVAO() == 0)) {
+        if (this->mode == INSTANCED) {
+            chunk.mesh.bind_instanced_buffers(this->unit_cube, chunk.boxes);
+        } else if (this->packed) {
+            chunk.mesh.bind_buffers(chunk.packed_vertices, chunk.indices);
+        } else {
+            chunk.mesh.bind_buffers(chunk.vertices, chunk.indices);
+        }
+    } else if (boxes) {
+        StreamBuffer* stream = this->streaming ? &this->stream : nullptr;
+        if (this->mode == INSTANCED) {
+            chunk.mesh.append_instances(chunk.boxes.data() + chunk.uploaded_boxes, chunk.boxes.size() - chunk.uploaded_boxes, stream);
+        } else if (this->packed) {
+            chunk.mesh.append_vertices(chunk.packed_vertices.data() + chunk.uploaded_vertices, chunk.packed_vertices.size() - chunk.uploaded_vertices, stream);
+            chunk.mesh.append_indices(chunk.indices.data() + chunk.uploaded_indices, chunk.indices.size() - chunk.uploaded_indices, stream);
+        } else {
+            chunk.mesh.append_vertices(chunk.vertices.data() + chunk.uploaded_vertices, chunk.vertices.size() - chunk.uploaded_vertices, stream);
+            chunk.mesh.append_indices(chunk.indices.data() + chunk.uploaded_indices, chunk.indices.size() - chunk.uploaded_indices, stream);
+        }
+    }
+
+    chunk.uploaded_boxes = chunk.boxes.size();
+    chunk.uploaded_vertices = this->packed ? chunk.packed_vertices.size() : chunk.vertices.size();
+    chunk.uploaded_indices = chunk.indices.size();
+    chunk.dirty = false;
+
+    if (chunk.remesh) {
+        chunk.remesh = false;
+        this->mesh_blocks(chunk);
+    }
+}
+
+size_t World::getBoxCount() {
+    size_t count = 0;
+    for (auto& entry : this->chunks) {
+        count += entry.second.boxes.size();
+    }
+    return count;
+}
+
+size_t World::getVertexCount() {
+    size_t count = 0;
+    for (auto& entry : this->chunks) {
+        const Chunk& chunk = entry.second;
+        count += chunk.vertices.size() + chunk.packed_vertices.size() + chunk.block_vertices.size() + chunk.packed_block_vertices.size();
+    }
+    return count;
+}
+
+size_t World::getVertexBytes() {
+    size_t bytes = 0;
+    for (auto& entry : this->chunks) {
+        const Chunk& chunk = entry.second;
+        bytes += (chunk.vertices.size() + chunk.block_vertices.size()) * sizeof(Vertex);
+        bytes += (chunk.packed_vertices.size() + chunk.packed_block_vertices.size()) * sizeof(PackedVertex);
+    }
+    return bytes;
+}
+
+size_t World::getIndexCount() {
+    size_t count = 0;
+    for (auto& entry : this->chunks) {
+        count += entry.second.indices.size() + entry.second.block_indices.size();
+    }
+    return count;
+}
+
+size_t World::getChunkCount() {
+    return this->chunks.size();
+}
+
+// Faces the world would draw with nothing culled: six per box plus the merged block quads
+size_t World::getFaceCount() {
+    size_t count = 0;
+    for (auto& entry : this->chunks) {
+        const Chunk& chunk = entry.second;
+        count += chunk.boxes.size() * 6 + chunk.block_quads;
+    }
+    return count;
+}
+
+// GPU storage of every chunk's block mesh, which shrinks back as blocks are removed
+size_t World::getBlockMeshBytes() {
+    size_t bytes = 0;
+    for (auto& entry : this->chunks) {
+        bytes += entry.second.block_mesh.getCapacity();
+    }
+    return bytes;
+}
+
+DrawStats World::getDrawStats() {
+    return this->stats;
+}
+
+uint64_t World::getChecksum() {
+    return this->checksum;
+}
+
+StreamBuffer& World::getStreamBuffer() {
+    return this->stream;
+}
@@ -0,0 +1,142 @@
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include "glm/glm/glm.hpp"
+#include "vertex.hpp"
+#include "cube.hpp"
+#include "greedy.hpp"
+#include "voxels.hpp"
+#include "raycast.hpp"
+#include "bvh.hpp"
+#include "collision.hpp"
+#include "occlusion.hpp"
+#include "mesh.hpp"
+#include "buffer.hpp"
+#include "frustum.hpp"
+#include "thread_pool.hpp"
+
+#ifndef WORLD_H
+#define WORLD_H
+
+// How boxes are turned into draw calls
+enum GeometryMode {
+    ARRAYS, // 36 expanded vertices per box, glDrawArrays
+    INDEXED, // 24 vertices + 36 indices per box, glDrawElements
+    INSTANCED // one unit cube drawn once per Instance record, glDrawElementsInstanced
+};
+
+// Chunks are columns of CHUNK_SIZE x CHUNK_SIZE world units over the ground plane
+const float CHUNK_SIZE = 64.0f;
+
+// Occlusion culling renders up to OCCLUDER_COUNT of the nearest boxes at least OCCLUDER_MIN_SIZE on every side
+const size_t OCCLUDER_COUNT = 64;
+const float OCCLUDER_MIN_SIZE = 5.0f;
+
+// A chunk owns the boxes whose origin falls inside it, the geometry derived from them and its own GPU mesh.
+// bounds covers every box and block in the chunk; boxes may reach past the chunk's own column. Blocks themselves
+// live in the World's VoxelStore, the chunk only keeps the greedy mesh derived from the ones in its column.
+struct Chunk {
+    int x, z;
+    std::vector<Instance> boxes;
+    BoundsArray box_bounds;
+    std::vector<Vertex> vertices;
+    std::vector<PackedVertex> packed_vertices; // used instead of vertices with set_packed_vertices
+    std::vector<unsigned int> indices;
+    float steps_per_unit = 0.0f; // quantization of packed_vertices, a power of two
+    Bounds bounds;
+    Mesh mesh;
+    bool dirty = false; // the GPU mesh is behind the CPU geometry
+    bool rebuild = false; // the CPU geometry has to be regenerated from boxes and fully re-uploaded
+    size_t uploaded_boxes = 0;
+    size_t uploaded_vertices = 0;
+    size_t uploaded_indices = 0;
+    size_t block_count = 0;
+    std::unordered_map<long long, std::vector<Quad>> brick_quads; // greedy quads of each brick in the chunk's column
+    std::vector<glm::ivec3> remesh_bricks; // bricks whose quads are out of date
+    std::vector<Vertex> block_vertices; // greedy mesh of the chunk's blocks, in the same layout as vertices
+    std::vector<PackedVertex> packed_block_vertices;
+    std::vector<unsigned int> block_indices;
+    size_t block_quads = 0;
+    Bounds block_bounds;
+    Mesh block_mesh;
+    bool remesh = false; // the block mesh has to be regenerated from brick_quads after remesh_bricks
+};
+
+// What the last draw() submitted and what it culled. Occluded counts are of boxes and chunks inside the frustum.
+struct DrawStats {
+    size_t drawn_boxes, culled_boxes, occluded_boxes;
+    size_t drawn_chunks, culled_chunks, occluded_chunks;
+    size_t occluders;
+    size_t draw_calls;
+    size_t drawn_vertices; // vertices the GPU runs through the vertex shader, 36 per box and 6 per merged block quad
+};
+
+// Spatially chunked world. Edits only touch the chunk they land in and are uploaded on the next upload().
+class World {
+public:
+    void set_geometry_mode(GeometryMode mode);
+    void set_streaming(bool streaming);
+    void set_culling(bool culling);
+    void set_occlusion(ThreadPool* pool);
+    void set_packed_vertices(bool packed);
+    void add_box(CubeSize size, Origin origin, Color color);
+    bool add_block(int x, int y, int z, Color color);
+    bool remove_block(int x, int y, int z);
+    bool hasBlock(int x, int y, int z);
+    const VoxelStore& getVoxels();
+    bool raycast(const glm::vec3& origin, const glm::vec3& direction, float max_distance, RayHit& hit);
+    glm::vec3 move(const Bounds& body, const glm::vec3& movement);
+    void add_boxes(const std::vector<Instance>& boxes, ThreadPool& pool);
+    void upload();
+    void draw(const Frustum& frustum, const glm::mat4& view_projection, const glm::vec3& eye);
+    void end_frame();
+    size_t getBoxCount();
+    size_t getVertexCount();
+    size_t getVertexBytes();
+    size_t getIndexCount();
+    size_t getChunkCount();
+    size_t getFaceCount();
+    size_t getBlockMeshBytes();
+    DrawStats getDrawStats();
+    uint64_t getChecksum();
+    StreamBuffer& getStreamBuffer();
+private:
+    Chunk& chunk_at(float x, float z);
+    Chunk& insert_box(const Instance& box);
+    void grow_bounds(Chunk& chunk, const Bounds& bounds);
+    void remesh_brick(int x, int y, int z);
+    void remesh_neighbours(int x, int y, int z);
+    void check_steps(Chunk& chunk);
+    void mark_dirty(Chunk& chunk);
+    void mesh_blocks(Chunk& chunk);
+    void append_geometry(Chunk& chunk, size_t first_box);
+    void upload_chunk(Chunk& chunk);
+    void render_occluders(const Frustum& frustum, const glm::mat4& view_projection, const glm::vec3& eye);
+    void draw_boxes(Chunk& chunk, const Frustum& frustum, bool occlusion);
+    void set_mesh_transform(const Chunk& chunk);
+    GeometryMode mode = ARRAYS;
+    std::unordered_map<long long, Chunk> chunks;
+    std::vector<Chunk*> dirty_chunks;
+    VoxelStore voxels;
+    Bvh box_tree; // every box's bounds again, in the order added, for raycasts and the broadphase of move()
+    Mesh unit_cube;
+    StreamBuffer stream = StreamBuffer(1 << 20);
+    bool streaming = false;
+    bool culling = true;
+    ThreadPool* occlusion_pool = nullptr; // renders the occlusion buffer, which is off without one
+    OcclusionBuffer occlusion;
+    std::vector<std::pair<float, const Chunk*>> nearest_chunks;
+    std::vector<Bounds> occluders;
+    bool packed = false;
+    DrawStats stats = {};
+    uint64_t checksum = 14695981039346656037ULL;
+    std::vector<unsigned char> visible;
+    std::vector<int> firsts;
+    std::vector<int> counts;
+    std::vector<const void*> offsets;
+    std::vector<Block> mesher_blocks;
+    std::vector<uint32_t> nearby_boxes;
+    std::vector<Bounds> obstacles;
+};
+
+#endif